@@ -45,10 +45,15 @@
 
 #include <string>
 #include <map>
+#include <unordered_map>
+#include <vector>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <regex>
+#include <mutex>
+
+#include <atools/parse.hh>
 
 using std::string;
 
@@ -63,9 +68,45 @@ protected:
   // typedef std::map<string,string>::iterator mapi;
   typedef std::map<string,string>::const_iterator mapci;
 
+  // Flattened view of each section, built at load time. Every key of the section, either
+  //    defined in it or inherited through "same = other_section" references, is found
+  //    with a single hash probe.
+  //    Values that are numbers are also kept parsed next to the raw string.
+  struct Location
+  {
+    mapci  entry;     // Entry in the section where the key is defined.
+    bool   inherited; // True if that section is not the indexed one.
+    bool   isNumber;
+    double number;
+
+    Location( const mapci& entry_, const bool& inherited_ )
+      : entry( entry_ ), inherited( inherited_ ), isNumber( false ), number( 0.0 )
+    {
+      isNumber = Parse::number( entry->second, number ) > 0;
+    }
+  };
+  struct SectionIndex
+  {
+    const std::map< std::string, std::string >* contents;
+    std::unordered_map< std::string, Location > keys;
+    std::vector< std::string >                  chain;   // Sections referenced through "same", in order.
+    std::string                                 missing; // Non-existent section at the end of the chain, if any.
+  };
+  std::unordered_map< std::string, SectionIndex > myIndex;
+
+  // Cache of compiled regular expressions for the wildcards that have been looked up.
+  mutable std::unordered_map< std::string, std::regex > myPatterns;
+  mutable std::mutex                                    myPatternsLock;
+
   mapci find( const std::string& wildcard ) const;
   mapci find( const std::string& section, const std::string& wildcard ) const;
 
+  void index();
+  void reindex( const std::string& section, const std::string& key );
+  const Location* lookup( const std::string& section, const std::string& wildcard, const bool& inherit = true ) const;
+  const std::regex& pattern( const std::string& wildcard ) const;
+  static bool isLiteral( const std::string& wildcard );
+
   // Methods
 public:
   ConfigFile( string filename,
@@ -73,6 +114,8 @@ public:
 	      string comment = "#",
 	      string sentry = "EndConfigFile" );
   ConfigFile();
+  ConfigFile( const ConfigFile& other );
+  ConfigFile& operator=( const ConfigFile& other );
 
   const std::map< std::string, std::string >& content() const { return myContents.at( "default" ); }
 
@@ -89,6 +132,13 @@ public:
   template<class T>
   bool readSecInto( T& var, const std::string& section, const string& key, const T& value ) const;
 
+  // Resolve several keys of a section at once, following "same" references.
+  //    Keys that are not found are returned as null pointers.
+  std::vector< const string* > resolve( const std::string& section, const std::vector< std::string >& keys ) const;
+
+  // Save or restore the flattened content in a binary snapshot, to skip text parsing.
+  void writeSnapshot( const string& filename ) const;
+  void readSnapshot ( const string& filename );
 
 
   // Modify keys and values
@@ -115,6 +165,7 @@ public:
 protected:
   template<class T> static string T_as_string( const T& t );
   template<class T> static T string_as_T( const string& s );
+  template<class T> static T location_as_T( const Location& loc );
   static void trim( string& s );
 
 
@@ -136,6 +187,18 @@ public:
       {}
     const std::string& what() const { return _section; }
   };
+  struct inheritance_cycle  // thrown when "same" references loop back to a section
+  {
+    std::string _section;
+    inheritance_cycle( const std::string& section = std::string() )
+      : _section( section )
+      {}
+    const std::string& what() const { return _section; }
+  };
+  struct bad_snapshot {
+    string filename;
+    bad_snapshot( const string& filename_ = string() )
+      : filename(filename_) {} };
 };
 
 
@@ -156,14 +219,32 @@ template<class T>
 T ConfigFile::string_as_T( const string& s )
 {
   // Convert from a string to a T
-  // Type T must support >> operator
-  T t;
-  std::istringstream ist(s);
-  ist >> t;
+  // Numbers are parsed in place; any other type T must support >> operator
+  T t = T();
+  if constexpr ( Parse::isNumber< T >::value )
+    Parse::number( s, t );
+  else
+  {
+    std::istringstream ist(s);
+    ist >> t;
+  }
   return t;
 }
 
 
+/* static */
+template<class T>
+T ConfigFile::location_as_T( const Location& loc )
+{
+  // Reuse the value parsed when the file was indexed, if any
+  if constexpr ( std::is_same< T, double >::value )
+    if ( loc.isNumber )
+      return loc.number;
+
+  return string_as_T< T >( loc.entry->second );
+}
+
+
 /* static */
 template<>
 inline string ConfigFile::string_as_T<string>( const string& s )
@@ -196,58 +277,28 @@ inline bool ConfigFile::string_as_T<bool>( const string& s )
 template< class T >
 T ConfigFile::readSection( const std::string& section, const std::string& key ) const // First argument is, e.g. ll|bdk-, second argument is the entry within that section
 {
-  // Make sure the section exists
-  std::map< std::string, std::map< std::string, std::string > >::const_iterator it = myContents.find( section );
-  if ( it == myContents.end() )
-    throw section_not_found( section );
-
-  // Find the key in the section map
-  ConfigFile::mapci p = find( section, key );
-  if ( p == it->second.end() )
-  {
-    // If the section defines "same = other_section", its content should be the same as other_section,
-    //    unless the key is found in the given section, in which case it overrides the default in other_section.
-    // Try to find the key in a section referenced by the key "same".
-    p = find( section, "same" );
-
-    if ( p == it->second.end() )
-      throw key_not_found( key );
-
-    return readSection< T >( p->second, key );
-  }
+  // If the section defines "same = other_section", its content should be the same as other_section,
+  //    unless the key is found in the given section, in which case it overrides the default in other_section.
+  //    These references are already resolved in the index.
+  const Location* found = lookup( section, key );
+  if ( ! found )
+    throw key_not_found( key );
 
   // Convert it to the templatized type
-  return string_as_T< T >( p->second ); // This is a boolean I think?
+  return location_as_T< T >( *found );
 }
 
 
 template< class T >
 T ConfigFile::readSection( const std::string& section, const std::string& key, const T& value ) const
 {
-  // Make sure the section exists
-  std::map< std::string, std::map< std::string, std::string > >::const_iterator it = myContents.find( section );
-  if ( it == myContents.end() )
-    throw section_not_found( section );
-
-  // Find the key in the section map
-  ConfigFile::mapci p = find( section, key );
-  if ( p == it->second.end() )
-  {
-    // If the section defines "same = other_section", its content should be the same as other_section,
-    //    unless the key is found in the given section, in which case it overrides the default in other_section.
-    // Try to find the key in a section referenced by the key "same".
-    p = find( section, "same" );
-
-    // If not found in the "same" section, return the default value.
-    if ( p == it->second.end() )
-      return value;
-
-    return readSection< T >( p->second, key, value );
-  }
-
+  // If not found in the section or in the ones it references, return the default value.
+  const Location* found = lookup( section, key );
+  if ( ! found )
+    return value;
 
   // Convert it to the templatized type
-  return string_as_T< T >( p->second );
+  return location_as_T< T >( *found );
 }
 
 
@@ -256,9 +307,9 @@ template<class T>
 T ConfigFile::read( const string& key ) const
 {
   // Read the value corresponding to key
-  ConfigFile::mapci p = find( key );
-  if( p == myContents.at( "default" ).end() ) throw key_not_found(key);
-  return string_as_T<T>( p->second );
+  const Location* p = lookup( "default", key, false );
+  if( !p ) throw key_not_found(key);
+  return location_as_T<T>( *p );
 }
 
 
@@ -268,9 +319,9 @@ T ConfigFile::read( const string& key, const T& value ) const
 {
   // Return the value corresponding to key or given default value
   // if key is not found
-  ConfigFile::mapci p = find( key );
-  if( p == myContents.at( "default" ).end() ) return value;
-  return string_as_T<T>( p->second );
+  const Location* p = lookup( "default", key, false );
+  if( !p ) return value;
+  return location_as_T<T>( *p );
 }
 
 
@@ -363,6 +414,9 @@ void ConfigFile::add( string key, const T& value )
   trim(key);
   trim(v);
   myContents["default"][key] = v;
+
+  // Index only the new key, in the default section and in those that inherit it.
+  reindex( "default", key );
   return;
 }
 
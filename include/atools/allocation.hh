@@ -0,0 +1,151 @@
+#ifndef __ALLOCATION_HH__
+#define __ALLOCATION_HH__
+
+#include <deque>
+#include <vector>
+
+// Accounting of the memory held by the containers of each subsystem. The containers
+//    declared as Allocation::Vector or Allocation::Deque with a tag are plain standard
+//    containers, unless the code is compiled with -DATOOLS_ALLOCATIONS (make
+//    ALLOCATIONS=1, after a make clean). Then they use a counting allocator, and when
+//    the process exits the live bytes, peak bytes and number of allocations of every
+//    tag are written to the standard error.
+
+#ifdef ATOOLS_ALLOCATIONS
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+
+#include <unistd.h>
+
+#endif
+
+
+class Allocation
+{
+public:
+  enum Tag { data, hist, dalitz, tuple, nTags };
+
+#ifdef ATOOLS_ALLOCATIONS
+
+private:
+  struct Totals
+  {
+    std::atomic< std::int64_t  > live;
+    std::atomic< std::int64_t  > peak;
+    std::atomic< std::uint64_t > allocations;
+
+    Totals() : live( 0 ), peak( 0 ), allocations( 0 ) {}
+
+    void add( const std::int64_t& bytes )
+    {
+      const std::int64_t& current = live += bytes;
+      std::int64_t highest = peak;
+      while ( current > highest && ! peak.compare_exchange_weak( highest, current ) );
+
+      if ( bytes > 0 )
+        allocations++;
+    }
+  };
+
+  struct State
+  {
+    Totals tags[ nTags ];
+    Totals total;
+    pid_t  pid;
+
+    State() : pid( getpid() ) {}
+
+    // Forked processes that leave normally do not report the memory of their parent.
+    ~State()
+    {
+      if ( getpid() == pid )
+        report( std::cerr );
+    }
+
+    void report( std::ostream& output ) const
+    {
+      static const char* names[ nTags ] = { "data", "hist", "dalitz", "tuple" };
+
+      output << "Memory of process " << getpid() << ":" << std::endl;
+      output << "   " << std::left << std::setw( 10 ) << "tag" << std::right
+             << std::setw( 16 ) << "live bytes" << std::setw( 16 ) << "peak bytes" << std::setw( 14 ) << "allocations" << std::endl;
+      for ( unsigned tag = 0; tag <= nTags; ++tag )
+      {
+        const Totals& totals = ( tag < nTags ) ? tags[ tag ] : total;
+        output << "   " << std::left << std::setw( 10 ) << ( ( tag < nTags ) ? names[ tag ] : "total" ) << std::right
+               << std::setw( 16 ) << totals.live << std::setw( 16 ) << totals.peak << std::setw( 14 ) << totals.allocations << std::endl;
+      }
+    }
+  };
+
+  static State& state()
+  {
+    static State state;
+    return state;
+  }
+
+public:
+  static void add( const Tag& tag, const std::int64_t& bytes )
+  {
+    State& state = Allocation::state();
+    state.tags[ tag ].add( bytes );
+    state.total      .add( bytes );
+  }
+
+  static void report( std::ostream& output )
+  {
+    state().report( output );
+  }
+
+  // Standard allocator that accounts its memory to a tag.
+  template< class T, Tag tag >
+  struct Allocator
+  {
+    typedef T value_type;
+
+    template< class U >
+    struct rebind
+    {
+      typedef Allocator< U, tag > other;
+    };
+
+    Allocator() {}
+    template< class U >
+    Allocator( const Allocator< U, tag >& ) {}
+
+    T* allocate( const std::size_t n )
+    {
+      T* memory = std::allocator< T >().allocate( n );
+      add( tag, n * sizeof( T ) );
+      return memory;
+    }
+
+    void deallocate( T* memory, const std::size_t n )
+    {
+      add( tag, -std::int64_t( n * sizeof( T ) ) );
+      std::allocator< T >().deallocate( memory, n );
+    }
+
+    template< class U >
+    bool operator==( const Allocator< U, tag >& ) const { return true;  }
+    template< class U >
+    bool operator!=( const Allocator< U, tag >& ) const { return false; }
+  };
+
+  template< class T, Tag tag > using Vector = std::vector< T, Allocator< T, tag > >;
+  template< class T, Tag tag > using Deque  = std::deque < T, Allocator< T, tag > >;
+
+#else
+
+  template< class T, Tag tag > using Vector = std::vector< T >;
+  template< class T, Tag tag > using Deque  = std::deque < T >;
+
+#endif
+};
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef __BENCH_HH__
+#define __BENCH_HH__
+
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstdint>
+#include <ostream>
+#include <iomanip>
+#include <algorithm>
+
+
+// Minimal harness for the benchmark programs. Each benchmark is run once to warm
+//    up and then timed a fixed number of times, and the results are written as JSON,
+//    keeping every repetition so that runs can be compared statistically.
+//    Options: --reps N (repetitions, 10 by default) and --filter STR (run only the
+//    benchmarks whose name contains STR).
+class Bench
+{
+private:
+  struct Result
+  {
+    std::string           name;
+    std::uint64_t         size;
+    std::vector< double > times; // Nanoseconds per repetition.
+  };
+
+  unsigned              _reps;
+  std::string           _filter;
+  std::vector< Result > _results;
+
+public:
+  Bench( int argc, char** argv ) : _reps( 10 )
+  {
+    for ( int arg = 1; arg + 1 < argc; ++arg )
+    {
+      const std::string& option = argv[ arg ];
+      if ( option == "--reps" )
+        _reps = std::max( 1, std::atoi( argv[ ++arg ] ) );
+      else if ( option == "--filter" )
+        _filter = argv[ ++arg ];
+    }
+  }
+
+  // Prevent the compiler from discarding a computed value.
+  template< class T >
+  static void keep( const T& value )
+  {
+    asm volatile( "" : : "g"( &value ) : "memory" );
+  }
+
+  // Time a function that processes size items. The setup function, if any, is
+  //    called before each repetition and is not timed.
+  template< class F, class S >
+  void run( const std::string& name, const std::uint64_t& size, F function, S setup )
+  {
+    if ( ! _filter.empty() && name.find( _filter ) == std::string::npos )
+      return;
+
+    Result result;
+    result.name = name;
+    result.size = size;
+
+    setup();
+    function();
+
+    for ( unsigned rep = 0; rep < _reps; ++rep )
+    {
+      setup();
+      const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+      function();
+      const std::chrono::steady_clock::time_point& stop  = std::chrono::steady_clock::now();
+      result.times.push_back( std::chrono::duration< double, std::nano >( stop - start ).count() );
+    }
+
+    _results.push_back( result );
+  }
+
+  template< class F >
+  void run( const std::string& name, const std::uint64_t& size, F function )
+  {
+    run( name, size, function, [](){} );
+  }
+
+  void write( std::ostream& out ) const
+  {
+    out << "{\n  \"unit\": \"ns\",\n  \"repetitions\": " << _reps << ",\n  \"benchmarks\": [";
+    for ( std::size_t res = 0; res < _results.size(); ++res )
+    {
+      const Result& result = _results[ res ];
+
+      std::vector< double > sorted( result.times );
+      std::sort( sorted.begin(), sorted.end() );
+      const std::size_t& n = sorted.size();
+      const double& median = ( n % 2 ) ? sorted[ n / 2 ] : 0.5 * ( sorted[ n / 2 - 1 ] + sorted[ n / 2 ] );
+
+      out << ( res ? "," : "" ) << "\n    { \"name\": \"" << result.name << "\", \"size\": " << result.size
+          << ", \"median\": " << std::fixed << std::setprecision( 1 ) << median
+          << ", \"times\": [";
+      for ( std::size_t time = 0; time < n; ++time )
+        out << ( time ? ", " : "" ) << result.times[ time ];
+      out << "] }";
+    }
+    out << "\n  ]\n}\n";
+  }
+};
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef __BINNINGSCHEME_HH__
+#define __BINNINGSCHEME_HH__
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <exception>
+
+#include <atools/data.hh>
+
+
+// Exception thrown when a binning scheme cannot be built, written or read.
+class BinningException : public std::exception
+{
+private:
+  std::string _msg;
+
+public:
+  BinningException( const std::string& msg ) : _msg( msg ) {}
+  ~BinningException()               throw() {}
+  const char* what()          const throw() { return _msg.c_str(); }
+};
+
+
+// Adaptive binning frozen from the tree of splittings of Data::adaptiveBins, to
+//    apply the same bins to other samples. It is written as a compact binary file,
+//    which is mapped in memory when read back, and points are assigned to bins by
+//    descending the tree, in logarithmic time in the number of bins. Batches of
+//    points descend interleaved, and are split across the threads of the Scheduler.
+class BinningScheme
+{
+public:
+  // File layout: a header, the nodes of the tree and the bins, in native byte order.
+  struct Header
+  {
+    char          magic[ 8 ];
+    std::uint32_t nNodes;
+    std::uint32_t nBins;
+    double        xmin;
+    double        xmax;
+    double        ymin;
+    double        ymax;
+  };
+
+  struct Node
+  {
+    double       xc;
+    double       yc[ 2 ];
+    std::int32_t child[ 4 ];
+    std::int32_t bin;      // Index of the bin of a leaf, or -1.
+    std::int32_t padding;
+  };
+
+  struct Record
+  {
+    double xlo;
+    double xhi;
+    double ylo;
+    double yhi;
+    double content;
+  };
+
+private:
+  std::vector< char > _storage; // Contents of a scheme that is not mapped.
+  void*               _map;
+  std::size_t         _mapSize;
+
+  const Header* _header;
+  const Node*   _nodes;
+  const Record* _bins;
+
+  void attach( const char* contents, const std::size_t& size );
+  void findRange( const double* x, const double* y, const std::size_t& begin, const std::size_t& end, int* bins ) const;
+
+public:
+  // Freeze the bins last computed by Data::adaptiveBins. Throw if data have been
+  //    added since then.
+  BinningScheme( const Data& data );
+
+  // Map a scheme written by save.
+  BinningScheme( const std::string& file );
+
+  BinningScheme( BinningScheme&& other );
+  BinningScheme( const BinningScheme& ) = delete;
+  BinningScheme& operator=( const BinningScheme& ) = delete;
+  ~BinningScheme();
+
+  void save( const std::string& file ) const;
+
+  const std::size_t size() const { return _header->nBins; }
+  const Bin         bin ( const std::size_t& index ) const;
+
+  // Index of the bin that contains a point, or -1 if it is outside the binning.
+  const int find( const double& x, const double& y ) const;
+
+  // Bin indices of a batch of points.
+  void find( const double* x, const double* y, const std::size_t& size, int* bins ) const;
+
+  // Number of points in each bin.
+  const std::vector< double > fill( const std::vector< double >& x, const std::vector< double >& y ) const;
+};
+
+#endif
@@ -2,12 +2,14 @@
 #define __BLIND_HH__
 
 #include <string>
+#include <string_view>
 #include <sstream>
-#include <cstdlib>
-#include <fcntl.h>
-#include <unistd.h>
+#include <vector>
+#include <cctype>
 
 #include <atools/base64.hh>
+#include <atools/entropy.hh>
+#include <atools/parse.hh>
 
 class Blind
 {
@@ -18,7 +20,10 @@ public:
   std::string blind  ( const std::string& str );
   std::string unblind( const std::string& str );
   template< class T > std::string blind  ( T value );
+  template< class T > std::vector< std::string > blind( const T* values, const std::size_t& size );
+  template< class T > std::vector< std::string > blind( const std::vector< T >& values ) { return blind( values.data(), values.size() ); }
   template< class T > T           unblind( const std::string& data );
+  template< class T > bool        isBlinded( const std::string_view& token ) const;
 };
 
 
@@ -26,34 +31,59 @@ public:
 template< class T >
 std::string Blind::blind( T value )
 {
-  // Read a random number from the random device.
-  char* key = new char[ _keyLength ];
-  int fd = open( "/dev/urandom", O_RDONLY );
-  if ( fd == -1 )
-    std::exit( 1 );
-  read( fd, key, _keyLength );
-  close( fd );
-
-  char* bytes = (char*) &value;
-  for( unsigned int pos = 0; pos < sizeof( T ); ++pos )
-    bytes[ pos ] ^= key[ pos % _keyLength ];
+  // The output is the random key followed by the value bytes xor'ed with it.
+  std::string output( _keyLength + sizeof( T ), '\0' );
+  Entropy::fill( &output[ 0 ], _keyLength );
 
-  std::string output;
-  std::copy( key  , key   + _keyLength , std::back_inserter( output ) );
-  std::copy( bytes, bytes + sizeof( T ), std::back_inserter( output ) );
+  const char* bytes = (const char*) &value;
+  for( unsigned int pos = 0; pos < sizeof( T ); ++pos )
+    output[ _keyLength + pos ] = bytes[ pos ] ^ output[ pos % _keyLength ];
 
   return "B" + base64_encode( output );
 }
 
 
+template< class T >
+std::vector< std::string > Blind::blind( const T* values, const std::size_t& size )
+{
+  // Take the random keys of all the values at once.
+  std::string keys( size * _keyLength, '\0' );
+  if ( size )
+    Entropy::fill( &keys[ 0 ], keys.size() );
+
+  std::vector< std::string > result;
+  result.reserve( size );
+
+  std::string output( _keyLength + sizeof( T ), '\0' );
+  for ( std::size_t val = 0; val < size; ++val )
+  {
+    const char* key   = keys.data() + val * _keyLength;
+    const char* bytes = (const char*) &values[ val ];
+
+    std::copy( key, key + _keyLength, output.begin() );
+    for( unsigned int pos = 0; pos < sizeof( T ); ++pos )
+      output[ _keyLength + pos ] = bytes[ pos ] ^ key[ pos % _keyLength ];
+
+    result.push_back( "B" + base64_encode( output ) );
+  }
+
+  return result;
+}
+
+
 template< class T >
 T Blind::unblind( const std::string& input )
 {
   if ( input[ 0 ] != 'B' )
   {
-    T output;
-    std::istringstream in( input );
-    in >> output;
+    T output = T();
+    if constexpr ( Parse::isNumber< T >::value )
+      Parse::number( input, output );
+    else
+    {
+      std::istringstream in( input );
+      in >> output;
+    }
     return output;
   }
 
@@ -71,5 +101,25 @@ T Blind::unblind( const std::string& input )
   return *((T*) &bytes[0]);
 }
 
+
+// Check if a token has the form of a value of type T blinded with this key length.
+template< class T >
+bool Blind::isBlinded( const std::string_view& token ) const
+{
+  // A leading B followed by the base 64 encoding of the key and the value bytes.
+  const std::size_t& length = 1 + 4 * ( ( _keyLength + sizeof( T ) + 2 ) / 3 );
+  if ( token.size() != length || token[ 0 ] != 'B' )
+    return false;
+
+  for ( std::size_t pos = 1; pos < length; ++pos )
+  {
+    const char& ch = token[ pos ];
+    if ( ! ( std::isalnum( (unsigned char) ch ) || ch == '+' || ch == '/' || ( ch == '=' && pos + 2 >= length ) ) )
+      return false;
+  }
+
+  return true;
+}
+
 #endif
 
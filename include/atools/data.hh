@@ -5,6 +5,9 @@
 #include <utility>
 #include <vector>
 #include <string>
+#include <cstddef>
+
+#include <atools/allocation.hh>
 
 class Datum
 {
@@ -34,6 +37,25 @@ public:
 
 
 
+// Datum of a two-sample binning, with the index of its sample and its index in the
+//    sample, which points to its weight. They are only put together while both samples
+//    are binned, so that the data of a single sample keep 16 bytes per event.
+class TaggedDatum : public Datum
+{
+private:
+  unsigned _sample;
+  unsigned _index;
+public:
+  TaggedDatum( const Datum& datum, const unsigned& sample, const unsigned& index )
+    : Datum( datum ), _sample( sample ), _index( index )
+  {}
+
+  const unsigned sample() const { return _sample; }
+  const unsigned index()  const { return _index;  }
+};
+
+
+
 class QuadrantSort
 {
 private:
@@ -84,40 +106,163 @@ public:
 
 
 
+// Adaptive bin with the contents of the data and the reference samples of a two-sample
+//    binning, and the sums of their squared weights. The content of the bin is the one
+//    of the data sample.
+class JointBin : public Bin
+{
+private:
+  double _content2;
+  double _reference;
+  double _reference2;
+
+public:
+  JointBin( const Bin& bin, const double& content2, const double& reference, const double& reference2 )
+    : Bin( bin ), _content2( content2 ), _reference( reference ), _reference2( reference2 )
+  {}
+
+  const double& content2()   const { return _content2;   }
+  const double& reference()  const { return _reference;  }
+  const double& reference2() const { return _reference2; }
+
+  // Difference between the samples, with the reference multiplied by scale, divided
+  //    by its uncertainty or by the sum of both. They are 0 for empty bins.
+  const double pull     ( const double& scale ) const;
+  const double asymmetry( const double& scale ) const;
+};
+
+
+
 class Dataset;
 
 class Data
 {
-private:
-  std::vector< Datum > _data;
-  std::vector< Bin   > _bins;
+public:
+  // Policy to split a range of data in quadrants. The centroid split cuts at the mean
+  //    x and y. The median split cuts at the median x, and each half at its own median
+  //    y, so the quadrants have equal populations, the tree is balanced and the bins
+  //    have between minEntries and about 4 minEntries events.
+  enum Split { centroidSplit, medianSplit };
 
-  bool _binsDone;
+  // Samples of a two-sample binning, to choose the ones the splittings are computed from.
+  enum Sample { dataSample, referenceSample, allSamples };
 
-  const std::pair< double, double > centroid( const std::vector< Datum >::const_iterator& begin,
-                                              const std::vector< Datum >::const_iterator& end );
+private:
+  friend class BinningScheme;
 
-  void adapt( const std::vector< Datum >::iterator& begin, const std::vector< Datum >::iterator& end,
-              const double& xmin, const double& xmax, const double& ymin, const double& ymax,
-              const unsigned& minEntries );
+  // Node of the tree of splittings that produces the adaptive bins. Leaves point to
+  //    their bin, and the other nodes to the children of each quadrant.
+  struct Node
+  {
+    double xc;
+    double yc[ 2 ]; // Splitting y of the lower and upper halves in x.
+    int    child[ 4 ];
+    int    bin;
+  };
+
+  typedef Allocation::Vector< Datum      , Allocation::data > Datums;
+  typedef Allocation::Vector< TaggedDatum, Allocation::data > TaggedDatums;
+
+  Datums                                            _data;
+  Datums                                            _reference;
+  Allocation::Vector< double  , Allocation::data > _weights; // Weights of the reference sample.
+  Allocation::Vector< Bin     , Allocation::data > _bins;
+  Allocation::Vector< JointBin, Allocation::data > _joint;
+  Allocation::Vector< Node    , Allocation::data > _tree;
+
+  // Limits of the region covered by the bins.
+  double _xmin;
+  double _xmax;
+  double _ymin;
+  double _ymax;
+
+  // Parameters of the computed bins.
+  Sample   _binned;
+  Split    _split;
+  unsigned _maxDepth;
+  unsigned _minEntries;
+  bool     _binsDone;
+  bool     _withJoint; // Whether to sum the contents of each sample in the bins.
+
+  // Sample and weight of a datum. Untagged data belong to the data sample.
+  static unsigned sample( const Datum&             ) { return dataSample;     }
+  static unsigned sample( const TaggedDatum& datum ) { return datum.sample(); }
+
+  double weight( const Datum&             ) const { return 1.0; }
+  double weight( const TaggedDatum& datum ) const { return ( datum.sample() == referenceSample ) ? _weights[ datum.index() ] : 1.0; }
+
+  // The splittings work on ranges of Datum, or of TaggedDatum when there is a reference sample.
+  template< class I >
+  const std::pair< double, double > centroid( const I& begin, const I& end );
+
+  template< class I, class C >
+  double median( const I& begin, const I& end,
+                 const C& coordinate, const double& lo, const double& hi, I& middle ) const;
+
+  // Number of data in a range from the samples the splittings are computed from.
+  template< class I >
+  std::ptrdiff_t count( const I& begin, const I& end ) const;
+
+  // Return the index of the node of the tree that covers the range.
+  template< class I >
+  int adapt( const I& begin, const I& end,
+             const double& xmin, const double& xmax, const double& ymin, const double& ymax,
+             const unsigned& depth );
+
+  void build( const double& xmin, const double& xmax, const double& ymin, const double& ymax,
+              const unsigned& minEntries, const Sample& binned, const Split& split, const unsigned& maxDepth,
+              const bool& withJoint );
 
 public:
-  Data() : _binsDone( false ) {}
+  Data()
+    : _xmin( 0.0 ), _xmax( 0.0 ), _ymin( 0.0 ), _ymax( 0.0 ),
+      _binned( allSamples ), _split( centroidSplit ), _maxDepth( 0 ), _minEntries( 0 ), _binsDone( false ), _withJoint( false )
+  {}
 
-  const unsigned size() const { return _data.size(); }
+  const unsigned size()          const { return _data.size();      }
+  const unsigned referenceSize() const { return _reference.size(); }
 
   void clear()
   {
     _data.clear();
+    _reference.clear();
+    _weights.clear();
     _bins.clear();
+    _joint.clear();
+    _tree.clear();
+    _binsDone = false;
   }
 
   void add( const double& x, const double y );
   void add( const Dataset& data, const std::string& xField, const std::string& yField );
 
+  // Add data to the reference sample of a two-sample binning, such as a reweighted
+  //    simulation or the sample of the conjugate mode. Without a weight field, all
+  //    the weights are 1.
+  void addReference( const double& x, const double& y, const double& weight = 1.0 );
+  void addReference( const Dataset& data, const std::string& xField, const std::string& yField,
+                     const std::string& weightField = "" );
+
+  // Split the region recursively in quadrants, until any of them would have fewer
+  //    than min events or the tree reaches maxDepth levels, if it is not 0. The bins
+  //    are reused while the data and the arguments do not change.
   std::vector< Bin > adaptiveBins( const double& xmin, const double& xmax,
                                    const double& ymin, const double& ymax,
-                                   const unsigned& min );
+                                   const unsigned& min,
+                                   const Split& split = centroidSplit, const unsigned& maxDepth = 0 );
+
+  // Same binning, with the splittings computed from the data of the binned samples
+  //    only, and with the contents of both samples, which are summed while the tree is
+  //    built. The minimum number of entries applies to the binned samples.
+  std::vector< JointBin > jointBins( const double& xmin, const double& xmax,
+                                     const double& ymin, const double& ymax,
+                                     const unsigned& min, const Sample& binned = allSamples,
+                                     const Split& split = centroidSplit, const unsigned& maxDepth = 0 );
+
+  // Index of the adaptive bin that contains a point, or -1 if it is outside all the bins
+  //    or data have been added since the bins were computed. The lookup descends the
+  //    tree of splittings, so it takes logarithmic time in the number of bins.
+  const int findBin( const double& x, const double& y ) const;
 };
 
 
@@ -0,0 +1,16 @@
+#ifndef __ENTROPY_HH__
+#define __ENTROPY_HH__
+
+#include <cstddef>
+
+
+// Source of random bytes for blinding keys. Each thread keeps a pool of random
+//    bytes that is refilled with a single getrandom call when it runs out, so
+//    blinding a value neither opens /dev/urandom nor allocates memory.
+class Entropy
+{
+public:
+  static void fill( char* buffer, const std::size_t& size );
+};
+
+#endif
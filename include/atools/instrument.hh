@@ -0,0 +1,241 @@
+#ifndef __INSTRUMENT_HH__
+#define __INSTRUMENT_HH__
+
+// Scoped timers and counters for the hot paths of the tools. They are compiled only
+//    with -DATOOLS_INSTRUMENT (make INSTRUMENT=1, after a make clean), and otherwise
+//    the macros expand to nothing.
+//    INSTRUMENT_SCOPE( "name" )       Time the enclosing scope as a stage of the timeline.
+//    INSTRUMENT_TIME ( "name" )       Add up the time of the enclosing scope, without
+//                                     recording each call in the timeline.
+//    INSTRUMENT_COUNT( counter, n )   Add n to a counter: pdfEvaluations, eventsFilled or bytesRead.
+//    INSTRUMENT_DUMP ()               Write the results now, e.g. before an _exit.
+// When the process exits, the time spent in each stage and the counters are written
+//    to the standard error, and the timeline to $ATOOLS_TRACE-<pid>.json, by default
+//    atools-trace-<pid>.json, in the Chrome trace format read by Perfetto.
+
+#ifdef ATOOLS_INSTRUMENT
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include <unistd.h>
+
+
+class Instrument
+{
+public:
+  enum Counter { pdfEvaluations, eventsFilled, bytesRead, nCounters };
+
+  // Totals of a stage, shared by all the calls of its scope.
+  struct Stage
+  {
+    const char*                  name;
+    std::atomic< std::uint64_t > calls;
+    std::atomic< std::uint64_t > nanoseconds;
+
+    Stage( const char* stage ) : name( stage ), calls( 0 ), nanoseconds( 0 ) {}
+  };
+
+  // Time a scope, adding it to the totals of its stage and, if requested, to the timeline.
+  class Timer
+  {
+  private:
+    Stage&        _stage;
+    bool          _trace;
+    std::uint64_t _begin;
+
+  public:
+    Timer( Stage& stage, const bool& trace ) : _stage( stage ), _trace( trace ), _begin( now() ) {}
+
+    ~Timer()
+    {
+      const std::uint64_t end = now();
+      _stage.calls++;
+      _stage.nanoseconds += end - _begin;
+
+      if ( _trace )
+        event( _stage.name, _begin, end );
+    }
+  };
+
+  // Stage of the given name. Each scope looks up its stage only once.
+  static Stage& stage( const char* name )
+  {
+    State& state = Instrument::state();
+    std::lock_guard< std::mutex > lock( state.lock );
+    state.stages.emplace_back( name );
+    return state.stages.back();
+  }
+
+  // Counts are kept per thread, so that they can be taken in inner loops.
+  static void count( const Counter& counter, const std::uint64_t& n )
+  {
+    local().counts[ counter ] += n;
+  }
+
+  static void dump()
+  {
+    local().flush();
+    state().dump();
+  }
+
+private:
+  struct Event
+  {
+    const char*   name;
+    std::uint64_t begin;
+    std::uint64_t end;
+    unsigned      thread;
+  };
+
+  struct State
+  {
+    std::mutex                   lock;
+    std::deque< Stage >          stages; // Stable addresses for the scopes.
+    std::vector< Event >         events;
+    std::atomic< std::uint64_t > counts[ nCounters ];
+    std::atomic< unsigned >      threads;
+    std::uint64_t                start;
+    pid_t                        pid;
+
+    State() : threads( 0 ), start( now() ), pid( getpid() )
+    {
+      for ( std::atomic< std::uint64_t >& count : counts )
+        count = 0;
+    }
+
+    // Forked processes that leave normally do not dump the results of their parent.
+    //    The counts of the main thread have already been added by then.
+    ~State()
+    {
+      if ( getpid() == pid )
+        dump();
+    }
+
+    void dump()
+    {
+      std::lock_guard< std::mutex > lock( this->lock );
+
+      const pid_t& self = getpid();
+      const std::uint64_t& end = now();
+
+      const std::ios::fmtflags& flags = std::cerr.flags();
+      const std::streamsize& precision = std::cerr.precision();
+
+      std::cerr << "Instrumentation of process " << self << ", " << std::fixed << std::setprecision( 3 )
+                << ( end - start ) * 1.0e-9 << " s:" << std::endl;
+      std::cerr << "   " << std::left << std::setw( 32 ) << "stage" << std::right
+                << std::setw( 12 ) << "calls" << std::setw( 14 ) << "total ms" << std::setw( 14 ) << "mean us" << std::endl;
+      for ( const Stage& stage : stages )
+        if ( stage.calls )
+          std::cerr << "   " << std::left << std::setw( 32 ) << stage.name << std::right
+                    << std::setw( 12 ) << stage.calls
+                    << std::setw( 14 ) << stage.nanoseconds * 1.0e-6
+                    << std::setw( 14 ) << stage.nanoseconds * 1.0e-3 / stage.calls << std::endl;
+      std::cerr << "   pdf evaluations " << counts[ pdfEvaluations ]
+                << ", events filled "    << counts[ eventsFilled   ]
+                << ", bytes read "       << counts[ bytesRead      ] << std::endl;
+      std::cerr.flags( flags );
+      std::cerr.precision( precision );
+
+      const char* prefix = std::getenv( "ATOOLS_TRACE" );
+      const std::string& file = std::string( prefix ? prefix : "atools-trace" ) + "-" + std::to_string( self ) + ".json";
+
+      std::ofstream trace( file.c_str() );
+      trace << std::fixed << std::setprecision( 3 );
+      trace << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+      for ( const Event& event : events )
+        trace << "\n{\"name\":\"" << event.name << "\",\"cat\":\"atools\",\"ph\":\"X\",\"pid\":" << self
+              << ",\"tid\":" << event.thread << ",\"ts\":" << ( event.begin - start ) * 1.0e-3
+              << ",\"dur\":" << ( event.end - event.begin ) * 1.0e-3 << "},";
+      trace << "\n{\"name\":\"counters\",\"cat\":\"atools\",\"ph\":\"C\",\"pid\":" << self
+            << ",\"tid\":0,\"ts\":" << ( end - start ) * 1.0e-3 << ",\"args\":{\"pdfEvaluations\":" << counts[ pdfEvaluations ]
+            << ",\"eventsFilled\":" << counts[ eventsFilled ] << ",\"bytesRead\":" << counts[ bytesRead ] << "}}]}" << std::endl;
+
+      if ( ! trace )
+        std::cerr << "Cannot write the timeline to " << file << "." << std::endl;
+    }
+  };
+
+  // Counters and identifier of a thread. The counts are added to the totals when
+  //    the thread finishes, or when the results are dumped.
+  struct Local
+  {
+    std::uint64_t counts[ nCounters ];
+    unsigned      thread;
+
+    Local() : counts(), thread( state().threads++ ) {}
+    ~Local() { flush(); }
+
+    void flush()
+    {
+      State& state = Instrument::state();
+      for ( unsigned counter = 0; counter < nCounters; ++counter )
+      {
+        state.counts[ counter ] += counts[ counter ];
+        counts[ counter ] = 0;
+      }
+    }
+  };
+
+  static State& state()
+  {
+    static State state;
+    return state;
+  }
+
+  static Local& local()
+  {
+    thread_local Local local;
+    return local;
+  }
+
+  static std::uint64_t now()
+  {
+    return std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+  }
+
+  static void event( const char* name, const std::uint64_t& begin, const std::uint64_t& end )
+  {
+    const unsigned& thread = local().thread;
+
+    State& state = Instrument::state();
+    std::lock_guard< std::mutex > lock( state.lock );
+    state.events.push_back( Event{ name, begin, end, thread } );
+  }
+};
+
+#define INSTRUMENT_JOIN_( a, b ) a##b
+#define INSTRUMENT_JOIN( a, b ) INSTRUMENT_JOIN_( a, b )
+
+#define INSTRUMENT_SCOPE( name )                                                                             \
+  static Instrument::Stage& INSTRUMENT_JOIN( instrumentStage, __LINE__ ) = Instrument::stage( name );        \
+  Instrument::Timer INSTRUMENT_JOIN( instrumentTimer, __LINE__ )( INSTRUMENT_JOIN( instrumentStage, __LINE__ ), true )
+
+#define INSTRUMENT_TIME( name )                                                                              \
+  static Instrument::Stage& INSTRUMENT_JOIN( instrumentStage, __LINE__ ) = Instrument::stage( name );        \
+  Instrument::Timer INSTRUMENT_JOIN( instrumentTimer, __LINE__ )( INSTRUMENT_JOIN( instrumentStage, __LINE__ ), false )
+
+#define INSTRUMENT_COUNT( counter, n ) Instrument::count( Instrument::counter, n )
+
+#define INSTRUMENT_DUMP() Instrument::dump()
+
+#else
+
+#define INSTRUMENT_SCOPE( name )
+#define INSTRUMENT_TIME( name )
+#define INSTRUMENT_COUNT( counter, n )
+#define INSTRUMENT_DUMP()
+
+#endif
+
+#endif
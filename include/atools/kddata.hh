@@ -0,0 +1,353 @@
+#ifndef __KDDATA_HH__
+#define __KDDATA_HH__
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include <numeric>
+
+#include <atools/allocation.hh>
+#include <atools/data.hh>
+#include <atools/instrument.hh>
+#include <atools/scheduler.hh>
+#include <atools/sum.hh>
+
+
+// Hyper-rectangular bin of K dimensions.
+template< unsigned K >
+class KdBin
+{
+private:
+  std::array< double, K > _lo;      // Bin vertices.
+  std::array< double, K > _hi;      //
+
+  double _content; // Bin content.
+
+public:
+  KdBin( const std::array< double, K >& lo, const std::array< double, K >& hi, const double& content )
+    : _lo( lo ), _hi( hi ), _content( content )
+  {}
+
+  // Getters.
+  const double& lo( const unsigned& axis ) const { return _lo[ axis ]; }
+  const double& hi( const unsigned& axis ) const { return _hi[ axis ]; }
+  const double& content()                  const { return _content;    }
+
+  const double volume() const
+  {
+    double volume = 1.0;
+    for ( unsigned axis = 0; axis < K; ++axis )
+      volume *= _hi[ axis ] - _lo[ axis ];
+    return volume;
+  }
+
+  // Setters.
+  void setContent( const double& content ) { _content = content; }
+
+  // Two dimensional bin, to draw with Hist2D.
+  const Bin bin() const
+  {
+    static_assert( K == 2, "Only two dimensional bins can be converted to Bin." );
+    return Bin( _lo[ 0 ], _hi[ 0 ], _lo[ 1 ], _hi[ 1 ], _content );
+  }
+};
+
+
+
+// Adaptive binning of K dimensional data, such as the phase space of four body decays,
+//    where uniform grids have too many bins. The coordinates are stored in one column
+//    per dimension. The bins are the leaves of a kd-tree, which halves each range of
+//    data at the median of one coordinate, until either half would have fewer than
+//    minEntries events, so each bin has between minEntries and 2 minEntries events.
+//    The axis of each splitting cycles through the dimensions, or is the one with the
+//    largest variance of the data. Large ranges are split in parallel with the
+//    threads of the Scheduler, and the tree is the same for any number of threads.
+//    In two dimensions, Data keeps its tree of quadrants, which binning schemes and
+//    two-sample binnings are built on.
+template< unsigned K >
+class KdData
+{
+public:
+  typedef std::array< double, K > Point;
+
+  enum Axis { cycleAxes, varianceAxis };
+
+private:
+  // Node of the kd-tree. Leaves point to their bin, and the other nodes to the
+  //    children below and above the cut.
+  struct Node
+  {
+    double   cut;
+    unsigned axis;
+    int      child[ 2 ];
+    int      bin;
+  };
+
+  typedef std::vector< std::size_t >::iterator Index;
+
+  // Nodes and bins of a subtree, in the order of a depth first traversal.
+  struct Tree
+  {
+    std::vector< Node       > nodes;
+    std::vector< KdBin< K > > bins;
+
+    // Append a subtree and return the index of its root.
+    int append( const Tree& sub )
+    {
+      const int& nodeOffset = nodes.size();
+      const int& binOffset  = bins .size();
+
+      for ( Node node : sub.nodes )
+      {
+        if ( node.bin < 0 )
+        {
+          node.child[ 0 ] += nodeOffset;
+          node.child[ 1 ] += nodeOffset;
+        }
+        else
+          node.bin += binOffset;
+        nodes.push_back( node );
+      }
+      bins.insert( bins.end(), sub.bins.begin(), sub.bins.end() );
+
+      return nodeOffset;
+    }
+  };
+
+  // Ranges with more data than this are split in parallel.
+  static constexpr std::size_t _grain = 1 << 16;
+
+  std::array< Allocation::Vector< double, Allocation::data >, K > _columns;
+
+  std::vector< Node       > _tree;
+  std::vector< KdBin< K > > _bins;
+
+  // Parameters of the computed bins.
+  Point    _lo;
+  Point    _hi;
+  unsigned _minEntries;
+  Axis     _axis;
+  unsigned _maxDepth;
+  bool     _binsDone;
+
+  unsigned splitAxis( const Index& begin, const Index& end, const unsigned& depth ) const;
+
+  // Add the nodes of the tree that covers a range to a subtree, and return its root.
+  int grow( const Index& begin, const Index& end, const Point& lo, const Point& hi,
+            const unsigned& depth, Tree& tree ) const;
+
+public:
+  KdData()
+    : _minEntries( 0 ), _axis( cycleAxes ), _maxDepth( 0 ), _binsDone( false )
+  {}
+
+  const unsigned size() const { return _columns[ 0 ].size(); }
+
+  void clear()
+  {
+    for ( unsigned axis = 0; axis < K; ++axis )
+      _columns[ axis ].clear();
+    _tree.clear();
+    _bins.clear();
+    _binsDone = false;
+  }
+
+  void add( const Point& point );
+
+  // Add the values of the given fields of a dataset, one per dimension.
+  template< class D >
+  void add( const D& data, const std::array< std::string, K >& fields );
+
+  // Split the region between lo and hi until any half would have fewer than min
+  //    events or the tree reaches maxDepth levels, if it is not 0. The bins are
+  //    reused while the data and the arguments do not change.
+  std::vector< KdBin< K > > adaptiveBins( const Point& lo, const Point& hi, const unsigned& min,
+                                          const Axis& axis = cycleAxes, const unsigned& maxDepth = 0 );
+
+  // Index of the adaptive bin that contains a point, or -1 if it is outside all the
+  //    bins or data have been added since the bins were computed.
+  const int findBin( const Point& point ) const;
+};
+
+
+template< unsigned K >
+void KdData< K >::add( const Point& point )
+{
+  for ( unsigned axis = 0; axis < K; ++axis )
+    _columns[ axis ].push_back( point[ axis ] );
+
+  // Since new data have been added, it's not possible to reuse previously computed bins.
+  _binsDone = false;
+}
+
+
+template< unsigned K >
+template< class D >
+void KdData< K >::add( const D& data, const std::array< std::string, K >& fields )
+{
+  INSTRUMENT_SCOPE( "KdData::add" );
+
+  std::array< std::vector< double >, K > values;
+  std::size_t nData = 0;
+  for ( unsigned axis = 0; axis < K; ++axis )
+  {
+    values[ axis ] = data.values( fields[ axis ] );
+    nData = axis ? std::min( nData, values[ axis ].size() ) : values[ axis ].size();
+  }
+  INSTRUMENT_COUNT( eventsFilled, nData );
+
+  for ( unsigned axis = 0; axis < K; ++axis )
+    _columns[ axis ].insert( _columns[ axis ].end(), values[ axis ].begin(), values[ axis ].begin() + nData );
+
+  // Since new data have been added, it's not possible to reuse previously computed bins.
+  _binsDone = false;
+}
+
+
+template< unsigned K >
+unsigned KdData< K >::splitAxis( const Index& begin, const Index& end, const unsigned& depth ) const
+{
+  if ( _axis == cycleAxes )
+    return depth % K;
+
+  // Axis with the largest variance, with sums that do not depend on the number of threads.
+  const std::size_t& nData = end - begin;
+
+  unsigned best     = 0;
+  double   variance = -1.0;
+  for ( unsigned axis = 0; axis < K; ++axis )
+  {
+    const Allocation::Vector< double, Allocation::data >& column = _columns[ axis ];
+
+    const double& mean = Sum::parallel( nData, [ & ]( const std::size_t& datum ) { return column[ begin[ datum ] ]; } ) / nData;
+    const double& var  = Sum::parallel( nData, [ & ]( const std::size_t& datum ) { const double& dev = column[ begin[ datum ] ] - mean; return dev * dev; } ) / nData;
+    if ( var > variance )
+    {
+      best     = axis;
+      variance = var;
+    }
+  }
+
+  return best;
+}
+
+
+template< unsigned K >
+int KdData< K >::grow( const Index& begin, const Index& end, const Point& lo, const Point& hi,
+                       const unsigned& depth, Tree& tree ) const
+{
+  const int node = tree.nodes.size();
+  tree.nodes.push_back( Node() );
+
+  const std::size_t& nData = end - begin;
+
+  // Halve the range at the median of the coordinate of the split axis. Values equal
+  //    to the median may lie on both sides of it.
+  unsigned axis   = 0;
+  double   cut    = 0.0;
+  Index    middle = end;
+  if ( nData >= 2 * std::size_t( _minEntries ) && nData && ! ( _maxDepth && depth + 1 >= _maxDepth ) )
+  {
+    const Allocation::Vector< double, Allocation::data >& column = _columns[ axis = splitAxis( begin, end, depth ) ];
+
+    const Index& nth = begin + ( nData - 1 ) / 2;
+    std::nth_element( begin, nth, end, [ &column ]( const std::size_t& left, const std::size_t& right ) { return column[ left ] < column[ right ]; } );
+
+    cut    = column[ *nth ];
+    middle = std::partition( nth + 1, end, [ &column, &cut ]( const std::size_t& datum ) { return column[ datum ] <= cut; } );
+  }
+
+  // If either half contains fewer elements than required by minEntries, or the
+  //    maximum depth has been reached, create a bin.
+  if ( middle - begin < _minEntries || end - middle < _minEntries || middle == end )
+  {
+    tree.nodes[ node ] = { cut, axis, { -1, -1 }, int( tree.bins.size() ) };
+    tree.bins.push_back( KdBin< K >( lo, hi, nData ) );
+    return node;
+  }
+
+  Point loUpper = lo;
+  Point hiLower = hi;
+  hiLower[ axis ] = loUpper[ axis ] = cut;
+
+  // Recurse, building the lower half in another thread if both halves are large.
+  int child[ 2 ];
+  if ( middle - begin > std::ptrdiff_t( _grain ) && end - middle > std::ptrdiff_t( _grain ) )
+  {
+    Tree lower, upper;
+
+    Scheduler::TaskGroup group;
+    group.run( [ & ]() { grow( begin, middle, lo, hiLower, depth + 1, lower ); } );
+    grow( middle, end, loUpper, hi, depth + 1, upper );
+    group.wait();
+
+    child[ 0 ] = tree.append( lower );
+    child[ 1 ] = tree.append( upper );
+  }
+  else
+  {
+    child[ 0 ] = grow( begin , middle, lo     , hiLower, depth + 1, tree );
+    child[ 1 ] = grow( middle, end   , loUpper, hi     , depth + 1, tree );
+  }
+
+  tree.nodes[ node ] = { cut, axis, { child[ 0 ], child[ 1 ] }, -1 };
+  return node;
+}
+
+
+template< unsigned K >
+std::vector< KdBin< K > > KdData< K >::adaptiveBins( const Point& lo, const Point& hi, const unsigned& minEntries,
+                                                     const Axis& axis, const unsigned& maxDepth )
+{
+  // If the bins are already evaluated, don't recompute them.
+  if ( _binsDone && lo == _lo && hi == _hi && minEntries == _minEntries && axis == _axis && maxDepth == _maxDepth )
+    return _bins;
+
+  INSTRUMENT_SCOPE( "KdData::adaptiveBins" );
+
+  _lo         = lo;
+  _hi         = hi;
+  _minEntries = minEntries;
+  _axis       = axis;
+  _maxDepth   = maxDepth;
+
+  // Reorder the indices of the data instead of the columns.
+  std::vector< std::size_t > indices( size() );
+  std::iota( indices.begin(), indices.end(), 0 );
+
+  Tree tree;
+  grow( indices.begin(), indices.end(), lo, hi, 0, tree );
+
+  _tree.swap( tree.nodes );
+  _bins.swap( tree.bins  );
+
+  // Mark the bins calculation as done, to avoid recomputing it unnecessarily.
+  _binsDone = true;
+
+  return _bins;
+}
+
+
+template< unsigned K >
+const int KdData< K >::findBin( const Point& point ) const
+{
+  if ( ! _binsDone || _tree.empty() )
+    return -1;
+
+  for ( unsigned axis = 0; axis < K; ++axis )
+    if ( point[ axis ] < _lo[ axis ] || point[ axis ] > _hi[ axis ] )
+      return -1;
+
+  int node = 0;
+  while ( _tree[ node ].bin < 0 )
+  {
+    const Node& split = _tree[ node ];
+    node = split.child[ point[ split.axis ] > split.cut ];
+  }
+
+  return _tree[ node ].bin;
+}
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef __PARSE_HH__
+#define __PARSE_HH__
+
+#include <charconv>
+#include <string_view>
+#include <type_traits>
+
+
+class Parse
+{
+public:
+  // Types read as numbers. Characters and booleans are not, as operator>> reads them differently.
+  template< class T >
+  struct isNumber
+    : std::integral_constant< bool, std::is_arithmetic< T >::value &&
+                                    ! std::is_same< T, bool          >::value &&
+                                    ! std::is_same< T, char          >::value &&
+                                    ! std::is_same< T, signed char   >::value &&
+                                    ! std::is_same< T, unsigned char >::value >
+  {};
+
+  static bool isSpace( const char& ch )
+  {
+    return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\v' || ch == '\f' || ch == '\r';
+  }
+
+  // Parse the number at the beginning of a string, skipping any leading whitespace
+  //    and ignoring whatever follows it, as operator>> does, but without building a stream.
+  //    Returns the number of characters consumed, or 0 if there is no valid number,
+  //    in which case value is left untouched.
+  template< class T >
+  static std::size_t number( const std::string_view& str, T& value );
+};
+
+
+
+template< class T >
+std::size_t Parse::number( const std::string_view& str, T& value )
+{
+  static_assert( isNumber< T >::value, "Parse::number only reads arithmetic types." );
+
+  const char* begin = str.data();
+  const char* end   = str.data() + str.size();
+
+  const char* first = begin;
+  while ( first != end && isSpace( *first ) )
+    ++first;
+
+  // Streams accept an explicit plus sign, std::from_chars does not.
+  if ( first != end && *first == '+' && first + 1 != end && *( first + 1 ) != '-' )
+    ++first;
+
+  T result;
+  std::from_chars_result parsed;
+  if constexpr ( std::is_floating_point< T >::value )
+    parsed = std::from_chars( first, end, result, std::chars_format::general );
+  else
+    parsed = std::from_chars( first, end, result );
+
+  if ( parsed.ec != std::errc() )
+    return 0;
+
+  value = result;
+  return parsed.ptr - begin;
+}
+
+#endif
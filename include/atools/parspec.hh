@@ -0,0 +1,57 @@
+#ifndef __PARSPEC_HH__
+#define __PARSPEC_HH__
+
+#include <string>
+#include <string_view>
+#include <exception>
+
+
+// Exception thrown when a parameter specification cannot be parsed.
+class ParSpecException : public std::exception
+{
+private:
+  std::string _msg;
+  std::size_t _pos;
+
+public:
+  ParSpecException( const std::string& msg, const std::size_t& pos ) : _msg( msg ), _pos( pos ) {}
+  ~ParSpecException()                   throw() {}
+  const char*        what()     const throw() { return _msg.c_str(); }
+  const std::size_t& position() const         { return _pos; }
+};
+
+
+// Content of a parameter specification, such as "1.2 +- 0.1 L( 0, 5 ) C B".
+class ParSpec
+{
+private:
+  double _value;
+  double _error;
+  double _loLimit;
+  double _upLimit;
+  bool   _fixed;
+  bool   _blind;
+  bool   _limited;
+  bool   _set;
+
+public:
+  ParSpec()
+    : _value( 0.0 ), _error( -1.0 ), _loLimit( 0.0 ), _upLimit( 0.0 ),
+      _fixed( false ), _blind( false ), _limited( false ), _set( false )
+  {}
+
+  // Parse a specification in a single pass, without modifying or copying it.
+  //    Throws ParSpecException with the position of the offending character.
+  static const ParSpec parse( const std::string_view& info );
+
+  const double& value()   const { return _value;   }
+  const double& error()   const { return _error;   }
+  const double& loLimit() const { return _loLimit; }
+  const double& upLimit() const { return _upLimit; }
+  const bool&   isFixed() const { return _fixed;   }
+  const bool&   isBlind() const { return _blind;   }
+  const bool&   limited() const { return _limited; }
+  const bool&   isSet()   const { return _set;     }
+};
+
+#endif
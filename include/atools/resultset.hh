@@ -0,0 +1,57 @@
+#ifndef __RESULTSET_HH__
+#define __RESULTSET_HH__
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+
+#include <atools/parspec.hh>
+
+
+// Collection of many fit results, such as those of a toy study, stored by column:
+//    the values, errors and limits of each parameter across all the results are
+//    kept in contiguous vectors, so that summaries are plain vector reductions.
+//    Entries of a parameter missing from some result are NaN.
+class ResultSet
+{
+public:
+  struct Column
+  {
+    std::vector< double > values;
+    std::vector< double > errors;
+    std::vector< double > loLimits;
+    std::vector< double > upLimits;
+  };
+
+private:
+  std::vector< std::string >                     _files;
+  std::vector< std::string >                     _names;
+  std::unordered_map< std::string, std::size_t > _index;
+  std::vector< Column >                          _columns;
+
+  static bool parse( const std::string& file, std::vector< std::pair< std::string, ParSpec > >& pars, std::string& error );
+
+public:
+  // Read all the files in parallel, with the threads of the Scheduler.
+  ResultSet( const std::vector< std::string >& files );
+
+  const std::size_t                 size()  const { return _files.size(); }
+  const std::vector< std::string >& files() const { return _files;        }
+  const std::vector< std::string >& names() const { return _names;        }
+
+  bool          contains( const std::string& name ) const { return _index.count( name ); }
+  const Column& column  ( const std::string& name ) const { return _columns.at( _index.at( name ) ); }
+
+  const std::vector< double >& values( const std::string& name ) const { return column( name ).values; }
+  const std::vector< double >& errors( const std::string& name ) const { return column( name ).errors; }
+
+  // Differences to the true value, plain or divided by the fitted error.
+  const std::vector< double > residuals( const std::string& name, const double& truth ) const;
+  const std::vector< double > pulls    ( const std::string& name, const double& truth ) const;
+
+  // Mean and standard deviation of a column, skipping NaN entries.
+  static const std::pair< double, double > meanAndSigma( const std::vector< double >& values );
+};
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef __SCHEDULER_HH__
+#define __SCHEDULER_HH__
+
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <functional>
+
+class ConfigFile;
+
+
+// Shared pool of worker threads for all the parallel work of the tools. Each worker
+//    has its own queue of tasks and, when it runs out of them, steals from the others.
+//    A thread that waits for tasks runs queued tasks meanwhile, so parallel loops can
+//    be nested. The number of threads is, by order of preference, the one given to
+//    configure, the ATOOLS_THREADS environment variable or the number of cores.
+//    Ranges are split in chunks that depend only on their size and grain, and
+//    reductions combine the chunks in order, so results do not depend on the number
+//    of threads. A forked process starts a pool of its own the first time it uses
+//    the Scheduler.
+class Scheduler
+{
+public:
+  // Set of tasks that can be waited for together. The first exception thrown by a
+  //    task is rethrown by wait.
+  class TaskGroup
+  {
+  private:
+    std::atomic< std::size_t > _pending;
+    std::exception_ptr         _error;
+    std::mutex                 _lock;
+
+  public:
+    TaskGroup() : _pending( 0 ) {}
+    ~TaskGroup() { wait( false ); }
+
+    void run( const std::function< void() >& task );
+    void wait( const bool& rethrow = true );
+  };
+
+  // Set the number of threads, including the calling one, and whether to pin each
+  //    worker to a core. A value of 0 restores the default. Call it before any
+  //    parallel work is running.
+  static void configure( const unsigned& nThreads, const bool& pin = false );
+
+  // Take the number of threads and the pinning from the "threads" and "pinThreads"
+  //    keys of a configuration file, when they are present.
+  static void configure( const ConfigFile& config );
+
+  static const unsigned nThreads();
+
+  // Call body( lo, hi ) for consecutive chunks of [begin, end) of grain elements
+  //    each. If grain is 0, the range is split in at most 256 chunks.
+  template< class Body >
+  static void parallel_for( const std::size_t& begin, const std::size_t& end, const Body& body, const std::size_t& grain = 0 );
+
+  // Reduce the values map( lo, hi ) of the chunks of [begin, end), combining them
+  //    with reduce( left, right ) in the order of the chunks, starting from identity.
+  template< class T, class Map, class Reduce >
+  static T parallel_reduce( const std::size_t& begin, const std::size_t& end, const T& identity,
+                            const Map& map, const Reduce& reduce, const std::size_t& grain = 0 );
+
+private:
+  static std::size_t chunk( const std::size_t& size, const std::size_t& grain );
+
+  // Queue a task, and run one queued task if there is any.
+  static void submit( const std::function< void() >& task );
+  static bool runOne();
+};
+
+
+template< class Body >
+void Scheduler::parallel_for( const std::size_t& begin, const std::size_t& end, const Body& body, const std::size_t& grain )
+{
+  if ( end <= begin )
+    return;
+
+  const std::size_t& step = chunk( end - begin, grain );
+  if ( step >= end - begin || nThreads() == 1 )
+  {
+    for ( std::size_t lo = begin; lo < end; lo += step )
+      body( lo, std::min( lo + step, end ) );
+    return;
+  }
+
+  TaskGroup group;
+  for ( std::size_t lo = begin; lo < end; lo += step )
+  {
+    const std::size_t hi = std::min( lo + step, end );
+    group.run( [ &body, lo, hi ]() { body( lo, hi ); } );
+  }
+  group.wait();
+}
+
+
+template< class T, class Map, class Reduce >
+T Scheduler::parallel_reduce( const std::size_t& begin, const std::size_t& end, const T& identity,
+                              const Map& map, const Reduce& reduce, const std::size_t& grain )
+{
+  if ( end <= begin )
+    return identity;
+
+  const std::size_t& step    = chunk( end - begin, grain );
+  const std::size_t& nChunks = ( end - begin + step - 1 ) / step;
+
+  std::vector< T > partial( nChunks, identity );
+  parallel_for( 0, nChunks, [ & ]( const std::size_t& first, const std::size_t& last )
+                {
+                  for ( std::size_t part = first; part < last; ++part )
+                    partial[ part ] = map( begin + part * step, std::min( begin + ( part + 1 ) * step, end ) );
+                }, 1 );
+
+  T result = identity;
+  for ( const T& value : partial )
+    result = reduce( result, value );
+
+  return result;
+}
+
+#endif
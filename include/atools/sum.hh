@@ -0,0 +1,87 @@
+#ifndef __SUM_HH__
+#define __SUM_HH__
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+#include <atools/scheduler.hh>
+
+
+// Reproducible sums of many terms. The terms are added in blocks of fixed size with
+//    eight interleaved partial sums, and the sums of the blocks are added pairwise,
+//    so the rounding error grows with the logarithm of the number of terms instead
+//    of linearly. The order of the additions depends only on the number of terms,
+//    so the serial and parallel sums are identical for any number of threads.
+//    The value function is called with the index of each term, from 0 to size - 1.
+class Sum
+{
+private:
+  static constexpr std::size_t _block = 256;
+
+  template< class F >
+  static double block( const std::size_t& begin, const std::size_t& end, const F& value )
+  {
+    double lane[ 8 ] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+
+    std::size_t index = begin;
+    for ( ; index + 8 <= end; index += 8 )
+      for ( unsigned k = 0; k < 8; ++k )
+        lane[ k ] += value( index + k );
+
+    for ( unsigned k = 0; index < end; ++index, ++k )
+      lane[ k ] += value( index );
+
+    return ( ( lane[ 0 ] + lane[ 1 ] ) + ( lane[ 2 ] + lane[ 3 ] ) ) + ( ( lane[ 4 ] + lane[ 5 ] ) + ( lane[ 6 ] + lane[ 7 ] ) );
+  }
+
+  // Add the blocks from first to last pairwise, taking the sum of each block from blockSum.
+  template< class B >
+  static double tree( const std::size_t& first, const std::size_t& last, const B& blockSum )
+  {
+    if ( last - first == 1 )
+      return blockSum( first );
+
+    const std::size_t& middle = first + ( last - first ) / 2;
+    return tree( first, middle, blockSum ) + tree( middle, last, blockSum );
+  }
+
+public:
+  template< class F >
+  static double serial( const std::size_t& size, const F& value )
+  {
+    if ( ! size )
+      return 0.0;
+
+    const std::size_t& nBlocks = ( size + _block - 1 ) / _block;
+    return tree( 0, nBlocks, [ & ]( const std::size_t& blk ) { return block( blk * _block, std::min( ( blk + 1 ) * _block, size ), value ); } );
+  }
+
+  // Evaluate the blocks with the threads of the Scheduler. The value function must
+  //    be safe to call from several threads.
+  template< class F >
+  static double parallel( const std::size_t& size, const F& value )
+  {
+    if ( size <= 64 * _block )
+      return serial( size, value );
+
+    const std::size_t& nBlocks = ( size + _block - 1 ) / _block;
+    std::vector< double > sums( nBlocks );
+    Scheduler::parallel_for( 0, nBlocks, [ & ]( const std::size_t& first, const std::size_t& last )
+                             {
+                               for ( std::size_t blk = first; blk < last; ++blk )
+                                 sums[ blk ] = block( blk * _block, std::min( ( blk + 1 ) * _block, size ), value );
+                             }, 64 );
+
+    return tree( 0, nBlocks, [ & ]( const std::size_t& blk ) { return sums[ blk ]; } );
+  }
+
+  // Sum of the elements of a container.
+  template< class C >
+  static double of( const C& values )
+  {
+    return serial( values.size(), [ & ]( const std::size_t& index ) { return values[ index ]; } );
+  }
+};
+
+#endif
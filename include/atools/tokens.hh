@@ -0,0 +1,119 @@
+#ifndef __TOKENS_HH__
+#define __TOKENS_HH__
+
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#include <atools/parse.hh>
+
+
+// Helpers for tools that rewrite whole text files token by token.
+class Tokens
+{
+public:
+  // Read a whole file, or the standard input if the name is "-".
+  static bool read( const std::string& file, std::string& content )
+  {
+    if ( file == "-" )
+    {
+      content.assign( std::istreambuf_iterator< char >( std::cin ), std::istreambuf_iterator< char >() );
+      return true;
+    }
+
+    std::ifstream input( file.c_str(), std::ios::binary );
+    if ( ! input )
+      return false;
+
+    input.seekg( 0, std::ios::end );
+    content.resize( input.tellg() );
+    input.seekg( 0, std::ios::beg );
+    input.read( &content[ 0 ], content.size() );
+
+    return bool( input );
+  }
+
+  // Split a text in whitespace separated tokens.
+  static std::vector< std::string_view > split( const std::string_view& text )
+  {
+    std::vector< std::string_view > tokens;
+
+    std::size_t pos = 0;
+    while ( pos < text.size() )
+    {
+      while ( pos < text.size() && Parse::isSpace( text[ pos ] ) )
+        ++pos;
+
+      const std::size_t begin = pos;
+      while ( pos < text.size() && ! Parse::isSpace( text[ pos ] ) )
+        ++pos;
+
+      if ( pos > begin )
+        tokens.push_back( text.substr( begin, pos - begin ) );
+    }
+
+    return tokens;
+  }
+
+  // Read all the numbers of a file, or of the standard input if the name is "-".
+  //    Return false if the file cannot be read or has a token that is not a number.
+  static bool numbers( const std::string& file, std::vector< double >& values, std::string& error )
+  {
+    std::string text;
+    if ( ! read( file, text ) )
+    {
+      error = "Cannot read file " + file + ".";
+      return false;
+    }
+
+    for ( const std::string_view& token : split( text ) )
+    {
+      double value = 0.0;
+      if ( Parse::number( token, value ) != token.size() )
+      {
+        error = "Token " + std::string( token ) + " is not a number.";
+        return false;
+      }
+      values.push_back( value );
+    }
+
+    return true;
+  }
+
+  // Copy a text replacing its whitespace separated tokens. The transform is called with
+  //    each token and the output string, and returns false if it did not append anything,
+  //    in which case the original token is kept. Whitespace is preserved as it is.
+  template< class F >
+  static std::string rewrite( const std::string_view& text, F transform )
+  {
+    std::string output;
+    output.reserve( text.size() + text.size() / 2 );
+
+    std::size_t pos = 0;
+    while ( pos < text.size() )
+    {
+      const std::size_t begin = pos;
+      if ( Parse::isSpace( text[ pos ] ) )
+      {
+        while ( pos < text.size() && Parse::isSpace( text[ pos ] ) )
+          ++pos;
+        output.append( text.data() + begin, pos - begin );
+        continue;
+      }
+
+      while ( pos < text.size() && ! Parse::isSpace( text[ pos ] ) )
+        ++pos;
+
+      const std::string_view& token = text.substr( begin, pos - begin );
+      if ( ! transform( token, output ) )
+        output.append( token.data(), token.size() );
+    }
+
+    return output;
+  }
+};
+
+#endif
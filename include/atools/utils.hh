@@ -10,6 +10,7 @@
 #include <cctype> // For ::toupper and ::tolower.
 
 #include <atools/blind.hh>
+#include <atools/parse.hh>
 
 class Amplitude;
 class ConfigFile;
@@ -27,10 +28,18 @@ public:
   template <class T>
   static T fromStr( const std::string& str )
   {
-    std::istringstream tempStr( str );
     T num;
-    if ( tempStr >> num )
-      return num;
+    if constexpr ( Parse::isNumber< T >::value )
+    {
+      if ( Parse::number( str, num ) )
+        return num;
+    }
+    else
+    {
+      std::istringstream tempStr( str );
+      if ( tempStr >> num )
+        return num;
+    }
 
     return Blind( 4 ).unblind< double >( str );
   }
@@ -90,7 +99,7 @@ public:
   static const std::string getOutput( const MnUserParameters& pars );
   static const std::string getOutput( const MnUserParameters& pars, const MnUserCovariance& cov );
 
-  static const Parameter   makePar ( const std::string& name, std::string info        );
+  static const Parameter   makePar ( const std::string& name, const std::string& info );
   static const Parameter   makePar ( const ConfigFile&  file, const std::string& name );
   static const Parameter   makePar ( const ConfigFile&  file, const std::string& section, const std::string& name );
   static const Parameter   makePar ( const ConfigFile&  file, const std::string& section, const std::string& name, const std::string& kstype );
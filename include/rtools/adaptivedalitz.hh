@@ -1,6 +1,8 @@
 #ifndef __ADAPTIVEDALITZ_HH__
 #define __ADAPTIVEDALITZ_HH__
 
+#include <functional>
+
 #include <cfit/phasespace.hh>
 #include <cfit/dataset.hh>
 
@@ -9,6 +11,8 @@
 
 #include <atools/data.hh>
 
+#include <rtools/plotcontext.hh>
+
 
 
 class AdaptiveDalitz
@@ -17,7 +21,9 @@ private:
   std::string _name;
   std::string _title;
 
-  unsigned _minEntries; // Minimum number of entries per bin.
+  unsigned    _minEntries; // Minimum number of entries per bin.
+  Data::Split _split;      // Policy to split the bins, and maximum depth
+  unsigned    _maxDepth;   //    of the splittings, if not 0.
 
   Data _data;
 
@@ -56,13 +62,26 @@ public:
 
   void setName ( const std::string& name  ) { _name  = name;  }
   void setTitle( const std::string& title ) { _title = title; }
+  void setSplit( const Data::Split& split, const unsigned& maxDepth = 0 ) { _split = split; _maxDepth = maxDepth; }
   void setData ( const Dataset& data, const std::string& field1, const std::string& field2 );
   void addData ( const Dataset& data, const std::string& field1, const std::string& field2 );
 
   void draw( const std::string& file = "" );
 
+  // Compute the adaptive bins of the data, which frame reuses. The pdfs are not
+  //    evaluated, so it can run in parallel for different plots.
+  void binData();
+
+  // Split drawing in the computation of the bins with their normalized residuals,
+  //    which can run in parallel for different plots, and their rendering.
+  const std::vector< Bin > frame();
+  void render( const std::vector< Bin >& bins, PlotContext& context, const std::function< void( TCanvas& ) >& output ) const;
+
   void addPdf( const PdfModel& pdf );
   void addPdf( const PdfExpr&  pdf );
+
+  // Index of the bin of the last frame that contains a point, or -1 if there is none.
+  const int findBin( const double& x, const double& y ) const { return _data.findBin( x, y ); }
 };
 
 #endif
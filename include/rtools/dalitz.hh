@@ -1,17 +1,26 @@
 #ifndef __DALITZ_HH__
 #define __DALITZ_HH__
 
+#include <functional>
+
 #include <cfit/phasespace.hh>
 #include <cfit/dataset.hh>
 #include <cfit/pdfexpr.hh>
 
+#include <atools/allocation.hh>
+
+#include <rtools/plotcontext.hh>
+
 class Dalitz
 {
 private:
+  typedef Allocation::Vector< double, Allocation::dalitz > Row;
+  typedef Allocation::Vector< Row   , Allocation::dalitz > Rows;
+
   std::string _name;
   std::string _title;
   int         _nbins;
-  std::vector< std::vector< double > > _binContent;
+  Rows        _binContent;
 
   PhaseSpace _ps;
 
@@ -36,11 +45,15 @@ public:
   void setTitle( const std::string& title ) { _title = title; }
   void setData ( const Dataset& data, const std::string& field1, const std::string& field2 );
   void addData ( const Dataset& data, const std::string& field1, const std::string& field2 );
+  void fill    ( const std::vector< double >& values1, const std::vector< double >& values2 );
 
   void setData ( const Function& data, const std::string& field1, const std::string& field2 );
 
   void draw( const std::string& file = "" );
 
+  // Draw the bin contents, calling the output function with the finished canvas.
+  void render( PlotContext& context, const std::function< void( TCanvas& ) >& output ) const;
+
   Dalitz* residuals( const PdfExpr& pdf, const std::string& field1, const std::string& field2, const std::string& field3 );
 };
 
@@ -3,9 +3,12 @@
 
 #include <string>
 #include <vector>
+#include <functional>
 
 #include <cfit/pdfbase.hh>
 
+#include <root/TCanvas.h>
+
 class Graph
 {
 private:
@@ -37,6 +40,9 @@ public:
   void addPdf  ( const PdfExpr&  pdf );
 
   void draw    ( const std::string& file = "" ) const;
+
+  // Draw the graph, calling the output function with the finished canvas.
+  void render  ( const std::function< void( TCanvas& ) >& output ) const;
 };
 
 
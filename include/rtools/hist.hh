@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include <functional>
 
 #include <cfit/dataset.hh>
 #include <cfit/pdfbase.hh>
@@ -11,9 +12,15 @@
 #include <root/TH1D.h>
 #include <root/TPad.h>
 
+#include <atools/allocation.hh>
+
+#include <rtools/plotcontext.hh>
+
 class Hist
 {
 private:
+  typedef Allocation::Vector< double, Allocation::hist > Contents;
+
   std::string             _name;
   std::string             _title;
   bool                    _withResiduals;
@@ -22,7 +29,7 @@ private:
   double                  _max;
 
   bool                    _allocatedData;
-  std::vector< double >   _binContent;
+  Contents                _binContent;
   std::vector< PdfBase* > _pdfs;
 
   double                  _underflow;
@@ -39,12 +46,12 @@ private:
   // Specify an integration region, if any.
   Region                  _region;
 
-  TH1D* residuals( const TH1D& data, const TH1D* pdf ) const;
+  void residuals( const std::vector< double >& data, const std::vector< double >& pdf, std::vector< double >& resids ) const;
 
   // TEMPORARY FUNCTION WHILE THERE'S NO PdfBase PROJECTION FUNCTION.
-  TH1D* project( const std::string& field, const double& area ) const;
+  void project( const std::string& field, const double& area, std::vector< double >& pdf ) const;
 
-  TH1D* getHist( const std::string& field, const double& area ) const;
+  void getHist( const std::string& field, const double& area, TH1D& pdf ) const;
 
   void cosmeticsData  ( TH1D& hist ) const;
   void cosmeticsResids( TH1D* hist ) const;
@@ -54,6 +61,15 @@ private:
 
 
 public:
+  // Numerical content of a plot. It does not involve any root object, so the
+  //    frames of many plots can be computed in parallel.
+  struct Frame
+  {
+    std::vector< double > data;
+    std::vector< double > pdf;
+    std::vector< double > resids;
+  };
+
   Hist( const unsigned& nbins, const double& min, const double& max )
     : _name         ( ""    ),
       _title        ( ""    ),
@@ -87,6 +103,7 @@ public:
   void setTitle( const std::string& title ) { _title = title; }
   void setData ( const Dataset&  data, const std::string& field );
   void addData ( const Dataset&  data, const std::string& field );
+  void fill    ( const std::vector< double >& values );
   void addPdf  ( const PdfModel& pdf );
   void addPdf  ( const PdfExpr&  pdf );
 
@@ -102,6 +119,14 @@ public:
 
   void draw    ( const std::string& file = "" ) const;
 
+  // Draw taking the histograms and the canvas from a context, to reuse them in batch plotting.
+  void draw    ( PlotContext& context, const std::string& file = "" ) const;
+
+  // Split drawing in the computation of the frame and its rendering. The output
+  //    function is called with the finished canvas, to save it.
+  const Frame frame () const;
+  void        render( const Frame& frame, PlotContext& context, const std::function< void( TCanvas& ) >& output ) const;
+
   const int    bin       ( const double& val ) const;
   const double binCenter ( const int&    bin ) const;
   const double binContent( const int&    bin ) const { return _binContent[ bin ]; };
@@ -44,7 +44,16 @@ public:
 
   void insert( const std::vector< Bin >& bins );
 
+  // Insert the pulls or the asymmetries of the data sample of two-sample bins with
+  //    respect to the reference sample, normalized to the same total content.
+  void insertPulls     ( const std::vector< JointBin >& bins );
+  void insertAsymmetries( const std::vector< JointBin >& bins );
+
   void draw( const std::string& filename, const bool& withCol = false ) const;
+
+  // Write the bins straight to a PNG image of the given size, with the colors of the
+  //    palette, without creating any root object per bin. No axes are drawn.
+  bool drawRaster( const std::string& filename, const unsigned& width = 800, const unsigned& height = 800 ) const;
 };
 
 
@@ -0,0 +1,51 @@
+#ifndef __PLOTCONTEXT_HH__
+#define __PLOTCONTEXT_HH__
+
+#include <map>
+#include <tuple>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <root/TH1D.h>
+#include <root/TCanvas.h>
+
+
+// Pool of the histograms and canvases used to draw plots. Objects taken from the
+//    context stay in use until release() is called, and are then kept to be reused
+//    by the following plots with the same binning or the same number of pads.
+//    Histograms are detached from gDirectory, so they never get registered in it.
+class PlotContext
+{
+private:
+  // Histograms are pooled by role and binning, so that the cosmetics of a role are
+  //    never inherited by another one.
+  typedef std::tuple< std::string, int, double, double > HistKey;
+
+  std::map   < HistKey, std::vector< std::unique_ptr< TH1D > > > _freeHists;
+  std::vector< std::pair< HistKey, std::unique_ptr< TH1D > > >   _usedHists;
+
+  std::map   < int, std::vector< std::unique_ptr< TCanvas > > >  _freeCanvases;
+  std::vector< std::pair< int, std::unique_ptr< TCanvas > > >    _usedCanvases;
+
+  unsigned _nCanvases;
+
+public:
+  PlotContext() : _nCanvases( 0 ) {}
+  PlotContext( const PlotContext& ) = delete;
+  PlotContext& operator=( const PlotContext& ) = delete;
+  ~PlotContext();
+
+  // Return an empty histogram with the given binning.
+  TH1D&    hist  ( const std::string& role, const std::string& name, const std::string& title,
+                   const int& nbins, const double& min, const double& max );
+
+  // Return a canvas divided in nPads pads, one on top of the other, with all of them cleared.
+  //    If nPads is 0, the canvas is not divided. The canvas becomes the current pad.
+  TCanvas& canvas( const std::string& name, const int& nPads, const int& width = 0, const int& height = 0 );
+
+  // Give back all the objects in use, to be reused by the next plots.
+  void release();
+};
+
+#endif
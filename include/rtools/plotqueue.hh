@@ -0,0 +1,66 @@
+#ifndef __PLOTQUEUE_HH__
+#define __PLOTQUEUE_HH__
+
+#include <string>
+#include <vector>
+#include <functional>
+
+#include <root/TCanvas.h>
+#include <root/TDirectory.h>
+
+#include <rtools/plotcontext.hh>
+
+class Hist;
+class Dalitz;
+class AdaptiveDalitz;
+
+
+// Queue of plots drawn in parallel. The adaptive binnings of the data are computed
+//    by the threads of the Scheduler, and the pdf projections are then evaluated in
+//    the calling thread, since cfit pdfs are not known to be safe to evaluate
+//    concurrently. The canvases are rendered by forked worker processes, since the
+//    root graphics are not thread safe. Each worker writes its canvases to a
+//    temporary root file, and the parent copies them to the current directory in
+//    the order the plots were added to the queue. The plotted objects must exist
+//    until run() returns.
+class PlotQueue
+{
+private:
+  typedef std::function< void( TCanvas& ) > Output;
+
+  struct Job
+  {
+    const void*                                          source;
+    std::function< void()                               > bin;
+    std::function< void()                               > compute;
+    std::function< void( PlotContext&, const Output& ) > render;
+    std::string                                          file;
+  };
+
+  std::vector< Job > _jobs;
+  unsigned           _nProcesses;
+
+  void compute();
+  void render ( const std::size_t& job, PlotContext& context, TDirectory& target );
+
+  // Render the jobs of a worker process into a temporary file, and return the exit status.
+  int  worker ( const unsigned& worker, const unsigned& nWorkers, const std::string& file );
+
+public:
+  // If nProcesses is 0, use as many as cores are available.
+  PlotQueue( const unsigned& nProcesses = 0 )
+    : _nProcesses( nProcesses )
+    {}
+
+  // Add a plot to the queue. If a file name is given, the plot is also printed to it.
+  void add( const Hist&           hist  , const std::string& file = "" );
+  void add( const Dalitz&         dalitz, const std::string& file = "" );
+  void add(       AdaptiveDalitz& dalitz, const std::string& file = "" );
+
+  const std::size_t size() const { return _jobs.size(); }
+
+  // Draw all the plots in the queue, write them to the current directory and empty the queue.
+  void run();
+};
+
+#endif
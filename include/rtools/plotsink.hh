@@ -0,0 +1,68 @@
+#ifndef __PLOTSINK_HH__
+#define __PLOTSINK_HH__
+
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
+
+#include <root/TCanvas.h>
+#include <root/TDirectory.h>
+
+
+// Collector of finished canvases. Canvases are copied when they are added, and all
+//    of them are written to the target directory in one go when the sink is flushed,
+//    optionally also as the pages of a single PDF file. Canvases printed to PNG files
+//    are captured as pixels and encoded by a background thread, so drawing never
+//    waits on image encoding. Any other file format is printed when flushing.
+class PlotSink
+{
+private:
+  struct Image
+  {
+    std::string                  file;
+    unsigned                     width;
+    unsigned                     height;
+    std::vector< std::uint32_t > argb;
+  };
+
+  TDirectory* _target;
+  std::string _pdf;
+
+  std::vector< std::pair< std::unique_ptr< TCanvas >, std::string > > _canvases;
+
+  // Queue of images waiting to be encoded.
+  std::deque< Image >       _images;
+  std::mutex                _lock;
+  std::condition_variable   _wakeup;
+  std::condition_variable   _idle;
+  bool                      _busy;
+  bool                      _stop;
+  std::thread               _encoder;
+
+  void encode();
+
+public:
+  // Write the canvases to the given directory, or to the current one if it is null.
+  //    If a PDF file name is given, every canvas is also printed as a page of it.
+  PlotSink( TDirectory* target = 0, const std::string& pdf = "" );
+  PlotSink( const PlotSink& ) = delete;
+  PlotSink& operator=( const PlotSink& ) = delete;
+  ~PlotSink();
+
+  // Keep a finished canvas, to be written and optionally printed to a file.
+  void add( TCanvas& canvas, const std::string& file = "" );
+
+  // Output function to pass to the render methods of the plots.
+  const std::function< void( TCanvas& ) > output( const std::string& file = "" );
+
+  // Write all the canvases kept so far and wait for the images to be encoded.
+  void flush();
+};
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef __PNG_HH__
+#define __PNG_HH__
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+// Minimal PNG writer for 8 bit RGB images, compressed with zlib. It does not use
+//    any root object, so images can be encoded away from the thread that draws them.
+class Png
+{
+public:
+  // Write an image given as 0xAARRGGBB pixels, row by row from the top. Alpha is ignored.
+  static bool write( const std::string& file, const unsigned& width, const unsigned& height,
+                     const std::vector< std::uint32_t >& argb );
+};
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef __POLYBUILDER_HH__
+#define __POLYBUILDER_HH__
+
+#include <utility>
+#include <vector>
+
+#include <root/TH2Poly.h>
+
+#include <atools/data.hh>
+
+
+// Builder of TH2Poly histograms with the rectangular bins of an adaptive binning.
+class PolyBuilder
+{
+public:
+  // Number of cells of the partition grid along each axis, chosen so that a cell has
+  //    about the size of the median bin. TH2Poly looks up points only among the bins
+  //    that overlap the cell of the point, so the cells should not be much larger
+  //    than the bins.
+  static const std::pair< int, int > partition( const std::vector< Bin >& bins,
+                                                const double& xmin, const double& xmax,
+                                                const double& ymin, const double& ymax );
+
+  // Add one bin per Bin, in the same order, and set their contents.
+  static void build( TH2Poly& hist, const std::vector< Bin >& bins );
+};
+
+#endif
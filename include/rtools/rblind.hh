@@ -1,36 +1,60 @@
 #ifndef __RBLIND_HH__
 #define __RBLIND_HH__
 
+#include <map>
+#include <memory>
 #include <string>
+#include <typeindex>
 
 #include <root/RooRealVar.h>
+#include <root/RooAbsHiddenReal.h>
 
 
+// Unblind RooFit blind values. The blind variable and one transform of each type are
+//    created the first time they are needed and reused for all the following values,
+//    since building RooFit objects is much slower than evaluating them.
 class RBlind
 {
 private:
   std::string _blindStr;
   double      _scale;
+  RooRealVar  _blind;
+
+  std::map< std::type_index, std::unique_ptr< RooAbsHiddenReal > > _transforms;
+
+  template< class T >
+  RooAbsHiddenReal& transform();
 public:
   RBlind( const std::string& blindStr, const double& scale )
-    : _blindStr( blindStr ), _scale( scale )
-    {}
+    : _blindStr( blindStr ), _scale( scale ), _blind( "blind", "blind", 0.0 )
+    {
+      _blind.setConstant( false );
+    }
   template< class T >
   const double unblind( const double& blindVal );
 };
 
 
+template< class T >
+RooAbsHiddenReal& RBlind::transform()
+{
+  std::unique_ptr< RooAbsHiddenReal >& unblind = _transforms[ typeid( T ) ];
+  if ( ! unblind )
+    unblind.reset( new T( "unblind", "unblind", _blindStr.data(), _scale, _blind ) );
+
+  return *unblind;
+}
+
+
 template< class T >
 const double RBlind::unblind( const double& blindVal )
 {
   // Unblind the blind value.
-  RooRealVar blind  ( "blind"  , "blind"  , blindVal );
-  T          unblind( "unblind", "unblind", _blindStr.data(), _scale, blind );
+  _blind.setVal( blindVal );
 
   // Return the hidden value.
-  return unblind.getHiddenVal();
+  return transform< T >().getHiddenVal();
 }
 
 
 #endif
-
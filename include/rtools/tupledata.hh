@@ -3,8 +3,11 @@
 
 #include <map>
 #include <string>
+#include <cstdint>
 #include <exception>
 
+#include <atools/allocation.hh>
+
 #include <root/TChain.h>
 #include <root/TBranch.h>
 
@@ -27,6 +30,7 @@ class TupleData
         int         _current;
         TChain*     _chain;
         std::map< std::string, void* > _values;
+        Allocation::Deque< std::uint64_t, Allocation::tuple > _buffers; // Storage of the branch values.
 
     public:
         TupleData( const std::string& branch, const std::string& files = "" );
@@ -44,13 +48,13 @@ class TupleData
         const double          min ( const std::string& varname, const double& def = 0.0 ) const;
         const double          max ( const std::string& varname, const double& def = 0.0 ) const;
 
-        template< class T > T get ( const std::string& varname ) const throw( BranchException );
+        template< class T > T get ( const std::string& varname ) const;
         template< class T > T get ( const std::string& varname, const T& defaultVal ) const;
 };
 
 
 // Get the value of the specified variable name.
-template< class T > T TupleData::get( const std::string& varname ) const throw( BranchException )
+template< class T > T TupleData::get( const std::string& varname ) const
 {
     std::map< std::string, void* >::const_iterator entry = _values.find( varname );
     if ( entry == _values.end() )
@@ -73,7 +77,7 @@ template< class T > T TupleData::get( const std::string& varname, const T& defau
 
 
 // Template specialization for int arrays.
-template<> inline int* TupleData::get< int* >( const std::string& varname ) const throw( BranchException )
+template<> inline int* TupleData::get< int* >( const std::string& varname ) const
 {
     std::map< std::string, void* >::const_iterator entry = _values.find( varname );
     if ( entry == _values.end() )
@@ -83,7 +87,7 @@ template<> inline int* TupleData::get< int* >( const std::string& varname ) cons
 }
 
 // Template specialization for float arrays.
-template<> inline float* TupleData::get< float* >( const std::string& varname ) const throw( BranchException )
+template<> inline float* TupleData::get< float* >( const std::string& varname ) const
 {
     std::map< std::string, void* >::const_iterator entry = _values.find( varname );
     if ( entry == _values.end() )
@@ -93,7 +97,7 @@ template<> inline float* TupleData::get< float* >( const std::string& varname )
 }
 
 // Template specialization for double arrays.
-template<> inline double* TupleData::get< double* >( const std::string& varname ) const throw( BranchException )
+template<> inline double* TupleData::get< double* >( const std::string& varname ) const
 {
     std::map< std::string, void* >::const_iterator entry = _values.find( varname );
     if ( entry == _values.end() )
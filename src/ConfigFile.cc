@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include <atools/ConfigFile.hh>
 
 using std::string;
@@ -23,20 +25,164 @@ ConfigFile::ConfigFile()
 }
 
 
+ConfigFile::ConfigFile( const ConfigFile& other )
+  : myDelimiter( other.myDelimiter ), myComment( other.myComment ), mySentry( other.mySentry ),
+    myContents( other.myContents )
+{
+  // The index refers to the contents of this object, so it cannot be copied.
+  index();
+}
 
-ConfigFile::mapci ConfigFile::find( const std::string& section, const std::string& wildcard ) const
+
+ConfigFile& ConfigFile::operator=( const ConfigFile& other )
 {
-  // std::map< std::string, std::map< std::string, std::string > >::const_iterator secmap = myContents.at( section );
+  if ( this == &other )
+    return *this;
+
+  myDelimiter = other.myDelimiter;
+  myComment   = other.myComment;
+  mySentry    = other.mySentry;
+  myContents  = other.myContents;
+
+  // The index refers to the contents of this object, so it cannot be copied.
+  index();
+
+  std::lock_guard< std::mutex > lock( myPatternsLock );
+  myPatterns.clear();
+
+  return *this;
+}
+
+
+// Flatten the content of every section into the hash index, resolving the
+//    "same = other_section" references once, at load time.
+void ConfigFile::index()
+{
+  myIndex.clear();
+  myIndex.reserve( myContents.size() );
+
+  typedef std::map< std::string, std::map< std::string, std::string > >::const_iterator sIter;
+  for ( sIter sec = myContents.begin(); sec != myContents.end(); ++sec )
+  {
+    SectionIndex& idx = myIndex[ sec->first ];
+    idx.contents = &sec->second;
+
+    // Walk the chain of references. Keys found earlier in the chain take precedence,
+    //    so emplace never overwrites them.
+    std::vector< std::string > visited( 1, sec->first );
+    sIter current = sec;
+    while ( true )
+    {
+      for ( mapci p = current->second.begin(); p != current->second.end(); ++p )
+        idx.keys.emplace( p->first, Location( p, current != sec ) );
+
+      mapci same = current->second.find( "same" );
+      if ( same == current->second.end() )
+        break;
 
-  std::map< std::string, std::map< std::string, std::string > >::const_iterator secmap = myContents.find( section );
+      if ( std::find( visited.begin(), visited.end(), same->second ) != visited.end() )
+        throw inheritance_cycle( sec->first );
 
-  if ( secmap == myContents.end() )
+      current = myContents.find( same->second );
+      if ( current == myContents.end() )
+      {
+        idx.missing = same->second;
+        break;
+      }
+
+      visited  .push_back( same->second );
+      idx.chain.push_back( same->second );
+    }
+  }
+}
+
+
+// Update the index after a key of a section has been added or modified, without
+//    flattening every section again.
+void ConfigFile::reindex( const std::string& section, const std::string& key )
+{
+  // New sections and references change the chains, so flatten everything.
+  if ( key == "same" || myIndex.find( section ) == myIndex.end() )
+  {
+    index();
+    return;
+  }
+
+  const mapci entry = myContents.at( section ).find( key );
+
+  typedef std::unordered_map< std::string, SectionIndex >::iterator iIter;
+  for ( iIter sec = myIndex.begin(); sec != myIndex.end(); ++sec )
+  {
+    SectionIndex& idx = sec->second;
+
+    // The key comes from the section if it is the indexed one, or if the section is in
+    //    its chain and no section before it defines the key.
+    bool reaches = ( sec->first == section );
+    if ( ! reaches && idx.contents->find( key ) == idx.contents->end() )
+      for ( std::vector< std::string >::const_iterator other = idx.chain.begin(); other != idx.chain.end(); ++other )
+      {
+        if ( *other == section )
+        {
+          reaches = true;
+          break;
+        }
+        if ( myIndex.at( *other ).contents->count( key ) )
+          break;
+      }
+
+    if ( reaches )
+    {
+      idx.keys.erase( key );
+      idx.keys.emplace( key, Location( entry, sec->first != section ) );
+    }
+  }
+}
+
+
+// Check if a wildcard contains no special regex characters, in which case
+//    matching it is equivalent to comparing it with the key.
+bool ConfigFile::isLiteral( const std::string& wildcard )
+{
+  return wildcard.find_first_of( "\\^$.|?*+()[]{}" ) == std::string::npos;
+}
+
+
+// Return the compiled regex for a wildcard, compiling it only the first time.
+const std::regex& ConfigFile::pattern( const std::string& wildcard ) const
+{
+  std::lock_guard< std::mutex > lock( myPatternsLock );
+
+  std::unordered_map< std::string, std::regex >::const_iterator p = myPatterns.find( wildcard );
+  if ( p == myPatterns.end() )
+    p = myPatterns.emplace( wildcard, std::regex( wildcard ) ).first;
+
+  // Elements of an unordered_map are never moved by later insertions.
+  return p->second;
+}
+
+
+
+ConfigFile::mapci ConfigFile::find( const std::string& section, const std::string& wildcard ) const
+{
+  std::unordered_map< std::string, SectionIndex >::const_iterator secidx = myIndex.find( section );
+
+  if ( secidx == myIndex.end() )
     throw section_not_found( section );
 
-  return std::find_if( secmap->second.begin(), secmap->second.end(),
+  const std::map< std::string, std::string >& secmap = *secidx->second.contents;
+
+  // A wildcard without special characters can only match a key identical to it.
+  if ( isLiteral( wildcard ) )
+  {
+    std::unordered_map< std::string, Location >::const_iterator p = secidx->second.keys.find( wildcard );
+    return ( p == secidx->second.keys.end() || p->second.inherited ) ? secmap.end() : p->second.entry;
+  }
+
+  const std::regex& regex = pattern( wildcard );
+  return std::find_if( secmap.begin(), secmap.end(),
                        [&]( std::pair< std::string, std::string > const& name )
                        {
-                         return std::regex_match( name.first, std::regex( wildcard ) );
+                         return std::regex_match( name.first, regex );
                        } );
 
   // return std::find_if( myContents.at( section ).begin(), myContents.at( section ).end(),
@@ -60,10 +206,234 @@ ConfigFile::mapci ConfigFile::find( const std::string& wildcard ) const
 
 
 
+// Find the value of a key in a section or, if requested, in the sections it references.
+//    Returns a null pointer if the key is not found anywhere.
+const ConfigFile::Location* ConfigFile::lookup( const std::string& section, const std::string& wildcard, const bool& inherit ) const
+{
+  std::unordered_map< std::string, SectionIndex >::const_iterator secidx = myIndex.find( section );
+
+  if ( secidx == myIndex.end() )
+    throw section_not_found( section );
+
+  const SectionIndex& idx = secidx->second;
+
+  if ( isLiteral( wildcard ) )
+  {
+    std::unordered_map< std::string, Location >::const_iterator p = idx.keys.find( wildcard );
+    if ( p != idx.keys.end() && ( inherit || ! p->second.inherited ) )
+      return &p->second;
+  }
+  else
+  {
+    // Real wildcards are matched against each section of the chain in turn.
+    mapci p = find( section, wildcard );
+    if ( p != idx.contents->end() )
+      return &idx.keys.at( p->first );
+
+    typedef std::vector< std::string >::const_iterator cIter;
+    for ( cIter other = idx.chain.begin(); inherit && other != idx.chain.end(); ++other )
+    {
+      const SectionIndex& otheridx = myIndex.at( *other );
+      p = find( *other, wildcard );
+      if ( p != otheridx.contents->end() )
+        return &otheridx.keys.at( p->first );
+    }
+  }
+
+  // Reading from a section that does not exist is an error, as it was when
+  //    the references were followed at lookup time.
+  if ( inherit && ! idx.missing.empty() )
+    throw section_not_found( idx.missing );
+
+  return 0;
+}
+
+
+std::vector< const string* > ConfigFile::resolve( const std::string& section, const std::vector< std::string >& keys ) const
+{
+  std::vector< const string* > values;
+  values.reserve( keys.size() );
+
+  for ( std::vector< std::string >::const_iterator key = keys.begin(); key != keys.end(); ++key )
+  {
+    const Location* found = lookup( section, *key );
+    values.push_back( found ? &found->entry->second : 0 );
+  }
+
+  return values;
+}
+
+
+// Binary snapshot helpers. Sizes are stored as 32 bit integers in native byte order.
+static void writeSize( std::ostream& os, const std::size_t& size )
+{
+  const unsigned int value = size;
+  os.write( (const char*) &value, sizeof( value ) );
+}
+
+static void writeString( std::ostream& os, const std::string& str )
+{
+  writeSize( os, str.size() );
+  os.write( str.data(), str.size() );
+}
+
+static std::size_t readSize( std::istream& is )
+{
+  unsigned int value = 0;
+  is.read( (char*) &value, sizeof( value ) );
+  return value;
+}
+
+static std::string readString( std::istream& is )
+{
+  std::string str( readSize( is ), '\0' );
+  is.read( &str[ 0 ], str.size() );
+  return str;
+}
+
+static const char snapshotMagic[] = "ATCF0001";
+
+
+void ConfigFile::writeSnapshot( const string& filename ) const
+{
+  std::ofstream out( filename.c_str(), std::ios::binary );
+
+  if( !out ) throw file_not_found( filename );
+
+  out.write( snapshotMagic, sizeof( snapshotMagic ) );
+  writeString( out, myDelimiter );
+  writeString( out, myComment   );
+  writeString( out, mySentry    );
+
+  // Store each section with its own keys, followed by the resolved inherited ones.
+  writeSize( out, myIndex.size() );
+  typedef std::unordered_map< std::string, SectionIndex >::const_iterator sIter;
+  for ( sIter sec = myIndex.begin(); sec != myIndex.end(); ++sec )
+  {
+    const SectionIndex& idx = sec->second;
+    writeString( out, sec->first );
+
+    writeSize( out, idx.contents->size() );
+    for ( mapci p = idx.contents->begin(); p != idx.contents->end(); ++p )
+    {
+      writeString( out, p->first  );
+      writeString( out, p->second );
+    }
+
+    writeSize( out, idx.chain.size() );
+    for ( std::vector< std::string >::const_iterator other = idx.chain.begin(); other != idx.chain.end(); ++other )
+      writeString( out, *other );
+    writeString( out, idx.missing );
+
+    // Inherited keys point into the chain, by position.
+    writeSize( out, idx.keys.size() - idx.contents->size() );
+    typedef std::unordered_map< std::string, Location >::const_iterator kIter;
+    for ( kIter key = idx.keys.begin(); key != idx.keys.end(); ++key )
+      if ( key->second.inherited )
+      {
+        std::size_t origin = 0;
+        for ( ; origin < idx.chain.size(); ++origin )
+        {
+          const std::map< std::string, std::string >& source = myContents.at( idx.chain[ origin ] );
+          mapci p = source.find( key->first );
+          if ( p != source.end() && &p->second == &key->second.entry->second )
+            break;
+        }
+        writeString( out, key->first );
+        writeSize  ( out, origin     );
+      }
+  }
+
+  if( !out ) throw bad_snapshot( filename );
+}
+
+
+void ConfigFile::readSnapshot( const string& filename )
+{
+  std::ifstream in( filename.c_str(), std::ios::binary );
+
+  if( !in ) throw file_not_found( filename );
+
+  char magic[ sizeof( snapshotMagic ) ];
+  in.read( magic, sizeof( magic ) );
+  if ( !in || std::string( magic, sizeof( magic ) ) != std::string( snapshotMagic, sizeof( snapshotMagic ) ) )
+    throw bad_snapshot( filename );
+
+  myDelimiter = readString( in );
+  myComment   = readString( in );
+  mySentry    = readString( in );
+
+  myContents.clear();
+  myIndex   .clear();
+
+  // Inherited keys can only be located once all the sections have been read.
+  std::vector< std::pair< std::string, std::vector< std::pair< std::string, std::size_t > > > > inherited;
+
+  const std::size_t nSections = readSize( in );
+  myIndex.reserve( nSections );
+  inherited.reserve( nSections );
+  for ( std::size_t sec = 0; sec < nSections && in; ++sec )
+  {
+    const std::string& name = readString( in );
+    std::map< std::string, std::string >& contents = myContents[ name ];
+    SectionIndex& idx = myIndex[ name ];
+    idx.contents = &contents;
+
+    const std::size_t nKeys = readSize( in );
+    idx.keys.reserve( nKeys );
+    for ( std::size_t k = 0; k < nKeys && in; ++k )
+    {
+      const std::string& key = readString( in );
+      mapci p = contents.emplace_hint( contents.end(), key, readString( in ) );
+      idx.keys.emplace( key, Location( p, false ) );
+    }
+
+    const std::size_t nChain = readSize( in );
+    for ( std::size_t c = 0; c < nChain && in; ++c )
+      idx.chain.push_back( readString( in ) );
+    idx.missing = readString( in );
+
+    inherited.emplace_back( name, std::vector< std::pair< std::string, std::size_t > >() );
+    const std::size_t nInherited = readSize( in );
+    for ( std::size_t k = 0; k < nInherited && in; ++k )
+    {
+      const std::string& key = readString( in );
+      inherited.back().second.emplace_back( key, readSize( in ) );
+    }
+  }
+
+  if ( !in )
+    throw bad_snapshot( filename );
+
+  for ( std::size_t sec = 0; sec < inherited.size(); ++sec )
+  {
+    SectionIndex& idx = myIndex.at( inherited[ sec ].first );
+    for ( std::size_t k = 0; k < inherited[ sec ].second.size(); ++k )
+    {
+      const std::string& key    = inherited[ sec ].second[ k ].first;
+      const std::size_t& origin = inherited[ sec ].second[ k ].second;
+      if ( origin >= idx.chain.size() || ! myContents.count( idx.chain[ origin ] ) )
+        throw bad_snapshot( filename );
+
+      const std::map< std::string, std::string >& source = myContents.at( idx.chain[ origin ] );
+      mapci p = source.find( key );
+      if ( p == source.end() )
+        throw bad_snapshot( filename );
+      idx.keys.emplace( key, Location( p, true ) );
+    }
+  }
+
+  std::lock_guard< std::mutex > lock( myPatternsLock );
+  myPatterns.clear();
+}
+
+
+
 void ConfigFile::remove( const string& key )
 {
   // Remove key and its value
   myContents.erase( myContents.find( key ) );
+  index();
   return;
 }
 
@@ -144,7 +514,7 @@ std::istream& operator>>( std::istream& is, ConfigFile& cf )
       line = line.substr( 0, line.find(comm) );
 
       // Check for end of file sentry
-      if( sentry != "" && line.find(sentry) != string::npos ) return is;
+      if( sentry != "" && line.find(sentry) != string::npos ) break;
 
       // Parse the section name if it is specified.
       if ( line.find( '[' ) == 0 )
@@ -195,5 +565,7 @@ std::istream& operator>>( std::istream& is, ConfigFile& cf )
 	}
     }
 
+  cf.index();
+
   return is;
 }
@@ -11,23 +11,27 @@
 #include <cfit/function.hh>
 
 #include <atools/data.hh>
+#include <atools/instrument.hh>
 #include <atools/utils.hh>
 
 #include <rtools/adaptivedalitz.hh>
 #include <rtools/contour.hh>
+#include <rtools/polybuilder.hh>
 
 
 
 // Constructor.
 AdaptiveDalitz::AdaptiveDalitz( const PhaseSpace& ps, const unsigned& minEntries )
-  : _name      ( ""           ),
-    _title     ( ""           ),
-    _minEntries( minEntries   ),
-    _ps        ( ps           ),
-    _mMother   ( ps.mMother() ),
-    _m1        ( ps.m1()      ),
-    _m2        ( ps.m2()      ),
-    _m3        ( ps.m3()      )
+  : _name      ( ""                  ),
+    _title     ( ""                  ),
+    _minEntries( minEntries          ),
+    _split     ( Data::centroidSplit ),
+    _maxDepth  ( 0                   ),
+    _ps        ( ps                  ),
+    _mMother   ( ps.mMother()        ),
+    _m1        ( ps.m1()             ),
+    _m2        ( ps.m2()             ),
+    _m3        ( ps.m3()             )
 {
   // Minimum and maximum values of the Dalitz variables.
   _mSq12min = std::pow( _m1      + _m2, 2 );
@@ -64,8 +68,34 @@ AdaptiveDalitz::~AdaptiveDalitz()
 
 void AdaptiveDalitz::draw( const std::string& file )
 {
+  PlotContext context;
+  render( frame(), context, [ &file ]( TCanvas& canvas )
+          {
+            // Write all of these things to the latest open file.
+            canvas.Write();
+
+            // If any file name has been given, print the plot on a file.
+            if ( ! file.empty() )
+            {
+              INSTRUMENT_SCOPE( "TCanvas::Print" );
+              canvas.Print( file.c_str() );
+            }
+          } );
+}
+
+
+void AdaptiveDalitz::binData()
+{
+  _data.adaptiveBins( _mSq12min, _mSq12max, _mSq13min, _mSq13max, _minEntries, _split, _maxDepth );
+}
+
+
+const std::vector< Bin > AdaptiveDalitz::frame()
+{
+  INSTRUMENT_SCOPE( "AdaptiveDalitz::frame" );
+
   // Retrieve the histogram bins, each with their data content.
-  std::vector< Bin > bins = _data.adaptiveBins( _mSq12min, _mSq12max, _mSq13min, _mSq13max, _minEntries );
+  std::vector< Bin > bins = _data.adaptiveBins( _mSq12min, _mSq12max, _mSq13min, _mSq13max, _minEntries, _split, _maxDepth );
 
   const unsigned& nData = _data.size();
 
@@ -83,7 +113,10 @@ void AdaptiveDalitz::draw( const std::string& file )
     double z = 0.0;
     for ( double x = bin->xlo(); x < bin->xhi(); x += dxy )
       for ( double y = bin->ylo(); y < bin->yhi(); y += dxy )
+      {
+        INSTRUMENT_COUNT( pdfEvaluations, 1 );
         z += _pdfs[ 0 ]->project( "mSq12", "mSq13", x, y );
+      }
     z *= std::pow( dxy, 2 );
 
     // Evaluate the normalized residual.
@@ -96,41 +129,22 @@ void AdaptiveDalitz::draw( const std::string& file )
     _zmax = std::max( _zmax, res );
   }
 
-  TH2Poly hist( ( "hist_" + _name ).data(), _title.c_str(), _xmin, _xmax, _ymin, _ymax );
+  return bins;
+}
 
-  // Bin index.
-  unsigned idx;
 
-  // Vectors to contain the bin content.
-  std::vector< double > xBin;
-  std::vector< double > yBin;
+void AdaptiveDalitz::render( const std::vector< Bin >& bins, PlotContext& context, const std::function< void( TCanvas& ) >& output ) const
+{
+  INSTRUMENT_SCOPE( "AdaptiveDalitz::render" );
 
-  for ( std::vector< Bin >::const_iterator bin = bins.begin(); bin != bins.end(); ++bin )
-  {
-    // Define the bin contour.
-    xBin.clear();
-    xBin.push_back( bin->xlo() );
-    xBin.push_back( bin->xlo() );
-    xBin.push_back( bin->xhi() );
-    xBin.push_back( bin->xhi() );
-    xBin.push_back( bin->xlo() );
-
-    yBin.clear();
-    yBin.push_back( bin->ylo() );
-    yBin.push_back( bin->yhi() );
-    yBin.push_back( bin->yhi() );
-    yBin.push_back( bin->ylo() );
-    yBin.push_back( bin->ylo() );
-
-    // Add a new bin to the histogram with the previously specified contour.
-    idx = hist.AddBin( xBin.size(), xBin.data(), yBin.data() );
-
-    // Set the histogram bin content to the bin object content.
-    hist.SetBinContent( idx, bin->content() );
-  }
+  TH2Poly hist( ( "hist_" + _name ).data(), _title.c_str(), _xmin, _xmax, _ymin, _ymax );
+  hist.SetDirectory( 0 );
+
+  // Add all the bins with their contents.
+  PolyBuilder::build( hist, bins );
 
   // Plot the data histogram.
-  TCanvas canvas( _name.c_str(), _name.c_str(), 800, 800 );
+  TCanvas& canvas = context.canvas( _name, 0, 800, 800 );
 
   // Configure the properties of the plot.
   hist.SetStats( false );
@@ -144,12 +158,11 @@ void AdaptiveDalitz::draw( const std::string& file )
   DalitzContour contour( _ps );
   contour.draw();
 
-  // Write all of these things to the latest open file.
-  canvas.Write();
+  output( canvas );
 
-  // If any file name has been given, print the plot on a file.
-  if ( ! file.empty() )
-    canvas.Print( file.c_str() );
+  // Clear the canvas while the objects drawn on it still exist.
+  canvas.Clear();
+  context.release();
 }
 
 
@@ -157,6 +170,8 @@ void AdaptiveDalitz::draw( const std::string& file )
 
 void AdaptiveDalitz::setData( const Dataset& data, const std::string& field1, const std::string& field2 )
 {
+  INSTRUMENT_SCOPE( "AdaptiveDalitz::setData" );
+
   // Set all bin contents to zero.
   _data.clear();
 
@@ -167,6 +182,8 @@ void AdaptiveDalitz::setData( const Dataset& data, const std::string& field1, co
 
 void AdaptiveDalitz::addData( const Dataset& data, const std::string& field1, const std::string& field2 )
 {
+  INSTRUMENT_SCOPE( "AdaptiveDalitz::addData" );
+
   // Fill the bin contents with every event.
   _data.add( data, field1, field2 );
 }
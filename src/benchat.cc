@@ -0,0 +1,121 @@
+
+#include <random>
+#include <sstream>
+#include <iostream>
+
+#include <atools/base64.hh>
+#include <atools/bench.hh>
+#include <atools/blind.hh>
+#include <atools/ConfigFile.hh>
+#include <atools/math.hh>
+#include <atools/parspec.hh>
+
+
+// Benchmarks of the atools hot paths on synthetic data, written as JSON to the standard output.
+//    All the inputs are generated from fixed seeds, so that runs are reproducible.
+int main( int argc, char** argv )
+{
+  Bench bench( argc, argv );
+  std::mt19937_64 random( 12345 );
+
+  // Base64 coding of a large buffer and of many short strings, as blinded values are.
+  {
+    std::string buffer( 1 << 20, '\0' );
+    for ( char& ch : buffer )
+      ch = char( random() );
+    const std::string& encoded = base64_encode( buffer );
+
+    bench.run( "base64_encode/1MiB", buffer.size(), [&]() { Bench::keep( base64_encode( buffer  ) ); } );
+    bench.run( "base64_decode/1MiB", buffer.size(), [&]() { Bench::keep( base64_decode( encoded ) ); } );
+
+    std::vector< std::string > values( 100000 );
+    for ( std::string& value : values )
+      value = buffer.substr( random() % ( buffer.size() - 12 ), 12 );
+
+    bench.run( "base64_encode/12B", values.size(), [&]() { for ( const std::string& value : values ) Bench::keep( base64_encode( value ) ); } );
+  }
+
+  // Blinding and unblinding of values.
+  {
+    Blind blinder( 4 );
+    std::uniform_real_distribution< double > uniform( -10.0, 10.0 );
+
+    std::vector< double > values( 100000 );
+    for ( double& value : values )
+      value = uniform( random );
+    const std::vector< std::string >& blinded = blinder.blind( values );
+
+    bench.run( "Blind::blind"      , values .size(), [&]() { for ( const double& value : values ) Bench::keep( blinder.blind( value ) ); } );
+    bench.run( "Blind::blind/bulk" , values .size(), [&]() { Bench::keep( blinder.blind( values ) ); } );
+    bench.run( "Blind::unblind"    , blinded.size(), [&]() { for ( const std::string& value : blinded ) Bench::keep( blinder.unblind< double >( value ) ); } );
+  }
+
+  // Parsing of a configuration file with many sections, and lookups in it.
+  {
+    const unsigned nSections = 100;
+    const unsigned nKeys     = 100;
+
+    std::ostringstream text;
+    text << "prefix = p\n\n";
+    for ( unsigned section = 0; section < nSections; ++section )
+    {
+      text << "[s" << section << "]\n";
+      for ( unsigned key = 0; key < nKeys; ++key )
+        text << "k" << key << " = " << section * nKeys + key << ".5 +- 0.1\n";
+      if ( section )
+        text << "same = s" << section - 1 << "\n";
+      text << "\n";
+    }
+    const std::string& content = text.str();
+
+    bench.run( "ConfigFile::parse", nSections * nKeys, [&]()
+               {
+                 std::istringstream input( content );
+                 ConfigFile config;
+                 input >> config;
+                 Bench::keep( config );
+               } );
+
+    ConfigFile config;
+    std::istringstream input( content );
+    input >> config;
+
+    std::vector< std::pair< std::string, std::string > > lookups( 100000 );
+    for ( std::pair< std::string, std::string >& lookup : lookups )
+    {
+      lookup.first  = "s" + std::to_string( random() % nSections );
+      lookup.second = "k" + std::to_string( random() % nKeys     );
+    }
+
+    bench.run( "ConfigFile::readSection", lookups.size(), [&]()
+               {
+                 for ( const std::pair< std::string, std::string >& lookup : lookups )
+                   Bench::keep( config.readSection< std::string >( lookup.first, lookup.second ) );
+               } );
+  }
+
+  // Parsing of parameter specifications, which is the core of Utils::makePar.
+  {
+    Blind blinder( 4 );
+    const std::vector< std::string > specs = { "1.5 +- 0.1", "-2.25 +- 0.01 C", "0.3 +- 0.02 L( 0, 1 )",
+                                               blinder.blind( 0.75 ) + " +- 0.05 B", "3e-4 +- no" };
+    std::vector< std::string > inputs( 100000 );
+    for ( std::size_t input = 0; input < inputs.size(); ++input )
+      inputs[ input ] = specs[ input % specs.size() ];
+
+    bench.run( "ParSpec::parse", inputs.size(), [&]() { for ( const std::string& input : inputs ) Bench::keep( ParSpec::parse( input ) ); } );
+  }
+
+  // Poisson errors and chi squared levels.
+  {
+    const unsigned nValues = 1000;
+
+    bench.run( "Math::errorLo"   , nValues, [&]() { for ( unsigned n = 0; n < nValues; ++n ) Bench::keep( Math::errorLo( n ) ); } );
+    bench.run( "Math::errorHi"   , nValues, [&]() { for ( unsigned n = 0; n < nValues; ++n ) Bench::keep( Math::errorHi( n ) ); } );
+    bench.run( "Math::chiSqLevel", nValues, [&]() { for ( unsigned n = 0; n < nValues; ++n ) Bench::keep( Math::chiSqLevel( 1.0 + n / 200.0, 1 + n % 5 ) ); } );
+  }
+
+  bench.write( std::cout );
+
+  return 0;
+}
@@ -0,0 +1,107 @@
+
+#include <random>
+#include <cstdlib>
+#include <iostream>
+
+#include <cfit/phasespace.hh>
+
+#include <atools/bench.hh>
+#include <atools/binningscheme.hh>
+#include <atools/data.hh>
+#include <atools/kddata.hh>
+
+#include <rtools/dalitz.hh>
+#include <rtools/hist.hh>
+
+
+// Benchmarks of the rtools hot paths on synthetic data, written as JSON to the standard output.
+//    All the inputs are generated from fixed seeds, so that runs are reproducible. The
+//    adaptive binning runs from 1e5 up to 1e7 points, or up to the number of points given
+//    with --max-points (e.g. 1e8, which needs a few GB of memory).
+int main( int argc, char** argv )
+{
+  Bench bench( argc, argv );
+  std::mt19937_64 random( 12345 );
+
+  double maxPoints = 1e7;
+  for ( int arg = 1; arg + 1 < argc; ++arg )
+    if ( std::string( argv[ arg ] ) == "--max-points" )
+      maxPoints = std::atof( argv[ arg + 1 ] );
+
+  // Adaptive binning of gaussian clusters of points.
+  for ( double nPoints = 1e5; nPoints <= maxPoints; nPoints *= 10 )
+  {
+    std::normal_distribution< double > gauss( 0.5, 0.15 );
+
+    Data base;
+    for ( std::size_t point = 0; point < std::size_t( nPoints ); )
+    {
+      const double& x = gauss( random );
+      const double& y = gauss( random );
+      if ( x < 0.0 || x > 1.0 || y < 0.0 || y > 1.0 )
+        continue;
+
+      base.add( x, y );
+      ++point;
+    }
+
+    // The binning reorders the points and is cached, so start each repetition from a copy.
+    Data data;
+    bench.run( "Data::adaptiveBins", std::size_t( nPoints ),
+               [&]() { Bench::keep( data.adaptiveBins( 0.0, 1.0, 0.0, 1.0, 20 ) ); },
+               [&]() { data = base; } );
+    bench.run( "Data::adaptiveBins/median", std::size_t( nPoints ),
+               [&]() { Bench::keep( data.adaptiveBins( 0.0, 1.0, 0.0, 1.0, 20, Data::medianSplit ) ); },
+               [&]() { data = base; } );
+
+    // Assignment of new points to frozen bins.
+    data = base;
+    data.adaptiveBins( 0.0, 1.0, 0.0, 1.0, 20 );
+    const BinningScheme scheme( data );
+
+    std::uniform_real_distribution< double > uniform( 0.0, 1.0 );
+    std::vector< double > x( base.size() );
+    std::vector< double > y( base.size() );
+    for ( std::size_t point = 0; point < x.size(); ++point )
+    {
+      x[ point ] = uniform( random );
+      y[ point ] = uniform( random );
+    }
+
+    bench.run( "BinningScheme::fill", x.size(), [&]() { Bench::keep( scheme.fill( x, y ) ); } );
+
+    // Binning of five dimensions, as for the phase space of four body decays.
+    KdData< 5 > base5;
+    for ( std::size_t point = 0; point < x.size(); ++point )
+      base5.add( { x[ point ], y[ point ], uniform( random ), uniform( random ), uniform( random ) } );
+
+    KdData< 5 > data5;
+    bench.run( "KdData<5>::adaptiveBins", x.size(),
+               [&]() { Bench::keep( data5.adaptiveBins( { 0.0, 0.0, 0.0, 0.0, 0.0 }, { 1.0, 1.0, 1.0, 1.0, 1.0 }, 20 ) ); },
+               [&]() { data5 = base5; } );
+  }
+
+  // Filling of one and two dimensional histograms.
+  {
+    const PhaseSpace ps( 1.86483, 0.497611, 0.13957, 0.13957 );
+
+    std::uniform_real_distribution< double > uniform( 0.0, 3.0 );
+    std::vector< double > values1( 1000000 );
+    std::vector< double > values2( 1000000 );
+    for ( std::size_t val = 0; val < values1.size(); ++val )
+    {
+      values1[ val ] = uniform( random );
+      values2[ val ] = uniform( random );
+    }
+
+    Hist hist( 100, 0.0, 3.0 );
+    bench.run( "Hist::fill", values1.size(), [&]() { hist.fill( values1 ); } );
+
+    Dalitz dalitz( 100, ps );
+    bench.run( "Dalitz::fill", values1.size(), [&]() { dalitz.fill( values1, values2 ); } );
+  }
+
+  bench.write( std::cout );
+
+  return 0;
+}
@@ -0,0 +1,257 @@
+
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <atools/binningscheme.hh>
+#include <atools/scheduler.hh>
+
+
+static const char magic[ 8 ] = { 'A', 'T', 'B', 'I', 'N', 'S', '0', '1' };
+
+
+static std::size_t fileSize( const std::size_t& nNodes, const std::size_t& nBins )
+{
+  return sizeof( BinningScheme::Header ) + nNodes * sizeof( BinningScheme::Node ) + nBins * sizeof( BinningScheme::Record );
+}
+
+
+BinningScheme::BinningScheme( const Data& data )
+  : _map( 0 ), _mapSize( 0 )
+{
+  // Data added after the binning make the tree and the bin contents stale.
+  if ( ! data._binsDone || data._tree.empty() )
+    throw BinningException( "The adaptive bins have not been computed for the current data." );
+
+  const std::size_t& nNodes = data._tree.size();
+  const std::size_t& nBins  = data._bins.size();
+
+  _storage.resize( fileSize( nNodes, nBins ) );
+
+  Header* header = (Header*) _storage.data();
+  std::memcpy( header->magic, magic, sizeof( magic ) );
+  header->nNodes = nNodes;
+  header->nBins  = nBins;
+  header->xmin   = data._xmin;
+  header->xmax   = data._xmax;
+  header->ymin   = data._ymin;
+  header->ymax   = data._ymax;
+
+  Node* nodes = (Node*) ( header + 1 );
+  for ( std::size_t node = 0; node < nNodes; ++node )
+  {
+    const Data::Node& split = data._tree[ node ];
+    nodes[ node ] = { split.xc, { split.yc[ 0 ], split.yc[ 1 ] },
+                      { split.child[ 0 ], split.child[ 1 ], split.child[ 2 ], split.child[ 3 ] }, split.bin, 0 };
+  }
+
+  Record* bins = (Record*) ( nodes + nNodes );
+  for ( std::size_t bin = 0; bin < nBins; ++bin )
+  {
+    const Bin& source = data._bins[ bin ];
+    bins[ bin ] = { source.xlo(), source.xhi(), source.ylo(), source.yhi(), source.content() };
+  }
+
+  attach( _storage.data(), _storage.size() );
+}
+
+
+BinningScheme::BinningScheme( const std::string& file )
+  : _map( 0 ), _mapSize( 0 )
+{
+  const int fd = open( file.c_str(), O_RDONLY );
+  if ( fd == -1 )
+    throw BinningException( "File " + file + " does not exist." );
+
+  struct stat info;
+  if ( fstat( fd, &info ) == -1 || std::size_t( info.st_size ) < sizeof( Header ) )
+  {
+    close( fd );
+    throw BinningException( "File " + file + " is not a binning scheme." );
+  }
+
+  _mapSize = info.st_size;
+  _map = mmap( 0, _mapSize, PROT_READ, MAP_PRIVATE, fd, 0 );
+  close( fd );
+  if ( _map == MAP_FAILED )
+  {
+    _map = 0;
+    throw BinningException( "Cannot map file " + file + "." );
+  }
+
+  try
+  {
+    attach( (const char*) _map, _mapSize );
+  }
+  catch ( BinningException& exc )
+  {
+    munmap( _map, _mapSize );
+    throw BinningException( "File " + file + ": " + exc.what() );
+  }
+}
+
+
+BinningScheme::BinningScheme( BinningScheme&& other )
+  : _storage( std::move( other._storage ) ),
+    _map    ( other._map     ),
+    _mapSize( other._mapSize ),
+    _header ( other._header  ),
+    _nodes  ( other._nodes   ),
+    _bins   ( other._bins    )
+{
+  other._map = 0;
+}
+
+
+BinningScheme::~BinningScheme()
+{
+  if ( _map )
+    munmap( _map, _mapSize );
+}
+
+
+// Point to the parts of the contents, checking that the tree cannot lead out of them.
+void BinningScheme::attach( const char* contents, const std::size_t& size )
+{
+  _header = (const Header*) contents;
+  if ( std::memcmp( _header->magic, magic, sizeof( magic ) ) || size != fileSize( _header->nNodes, _header->nBins ) || ! _header->nNodes )
+    throw BinningException( "Invalid binning scheme." );
+
+  _nodes = (const Node*  ) ( _header + 1 );
+  _bins  = (const Record*) ( _nodes + _header->nNodes );
+
+  const std::int32_t nNodes = _header->nNodes;
+  const std::int32_t nBins  = _header->nBins;
+  for ( std::int32_t node = 0; node < nNodes; ++node )
+  {
+    const Node& split = _nodes[ node ];
+    if ( split.bin >= nBins )
+      throw BinningException( "Invalid bin index." );
+
+    // Children always come after their parent, so the descent cannot loop.
+    if ( split.bin < 0 )
+      for ( const std::int32_t& child : split.child )
+        if ( child <= node || child >= nNodes )
+          throw BinningException( "Invalid tree of splittings." );
+  }
+}
+
+
+void BinningScheme::save( const std::string& file ) const
+{
+  std::ofstream output( file.c_str(), std::ios::binary | std::ios::trunc );
+  output.write( (const char*) _header, fileSize( _header->nNodes, _header->nBins ) );
+
+  if ( ! output )
+    throw BinningException( "Cannot write file " + file + "." );
+}
+
+
+const Bin BinningScheme::bin( const std::size_t& index ) const
+{
+  const Record& record = _bins[ index ];
+  return Bin( record.xlo, record.xhi, record.ylo, record.yhi, record.content );
+}
+
+
+const int BinningScheme::find( const double& x, const double& y ) const
+{
+  // Written so that NaN coordinates are also outside.
+  if ( ! ( x >= _header->xmin && x <= _header->xmax && y >= _header->ymin && y <= _header->ymax ) )
+    return -1;
+
+  std::int32_t node = 0;
+  while ( _nodes[ node ].bin < 0 )
+  {
+    const Node& split = _nodes[ node ];
+    const bool& upper = x > split.xc;
+    node = split.child[ 2 * upper + ( y > split.yc[ upper ] ) ];
+  }
+
+  return _nodes[ node ].bin;
+}
+
+
+// Descend the tree with groups of points at once, so that their memory accesses overlap.
+void BinningScheme::findRange( const double* x, const double* y, const std::size_t& begin, const std::size_t& end, int* bins ) const
+{
+  const std::size_t group = 8;
+
+  std::size_t first = begin;
+  for ( ; first + group <= end; first += group )
+  {
+    std::int32_t node[ group ] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+    bool descending = true;
+    while ( descending )
+    {
+      descending = false;
+      for ( std::size_t point = 0; point < group; ++point )
+      {
+        const Node& split = _nodes[ node[ point ] ];
+        if ( split.bin >= 0 )
+          continue;
+
+        const bool& upper = x[ first + point ] > split.xc;
+        node[ point ] = split.child[ 2 * upper + ( y[ first + point ] > split.yc[ upper ] ) ];
+        descending = true;
+      }
+    }
+
+    for ( std::size_t point = 0; point < group; ++point )
+    {
+      const double& xp = x[ first + point ];
+      const double& yp = y[ first + point ];
+      const bool inside = xp >= _header->xmin && xp <= _header->xmax && yp >= _header->ymin && yp <= _header->ymax;
+      bins[ first + point ] = inside ? _nodes[ node[ point ] ].bin : -1;
+    }
+  }
+
+  for ( ; first < end; ++first )
+    bins[ first ] = find( x[ first ], y[ first ] );
+}
+
+
+void BinningScheme::find( const double* x, const double* y, const std::size_t& size, int* bins ) const
+{
+  Scheduler::parallel_for( 0, size, [ & ]( const std::size_t& begin, const std::size_t& end )
+                           {
+                             findRange( x, y, begin, end, bins );
+                           }, 1 << 16 );
+}
+
+
+const std::vector< double > BinningScheme::fill( const std::vector< double >& x, const std::vector< double >& y ) const
+{
+  if ( x.size() != y.size() )
+    throw BinningException( "The coordinates have different numbers of points." );
+
+  const std::size_t& nBins = size();
+
+  // Count each chunk of points separately, and add the counts in order.
+  return Scheduler::parallel_reduce( 0, x.size(), std::vector< double >( nBins, 0.0 ),
+                                     [ & ]( const std::size_t& begin, const std::size_t& end )
+                                     {
+                                       std::vector< double > counts( nBins, 0.0 );
+                                       std::vector< int    > bins  ( 4096 );
+                                       for ( std::size_t first = begin; first < end; first += bins.size() )
+                                       {
+                                         const std::size_t last = std::min( first + bins.size(), end );
+                                         findRange( x.data() + first, y.data() + first, 0, last - first, bins.data() );
+                                         for ( std::size_t point = first; point < last; ++point )
+                                           if ( bins[ point - first ] >= 0 )
+                                             counts[ bins[ point - first ] ]++;
+                                       }
+                                       return counts;
+                                     },
+                                     []( std::vector< double > total, const std::vector< double >& counts )
+                                     {
+                                       for ( std::size_t bin = 0; bin < total.size(); ++bin )
+                                         total[ bin ] += counts[ bin ];
+                                       return total;
+                                     }, 1 << 20 );
+}
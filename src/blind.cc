@@ -1,24 +1,13 @@
-#include <fstream>
-
 #include <atools/base64.hh>
 #include <atools/blind.hh>
+#include <atools/entropy.hh>
 
 
 std::string Blind::blind( const std::string& input )
 {
-  // Read a random number from the random device.
-  std::ifstream random( "/dev/urandom" );
-  char* rnd = new char[ _keyLength ];
-  random.read( rnd, _keyLength );
-  random.close();
-
-  // Define the key as this random number. Cannot do key = std::string( rnd ), since
-  //    rnd may contain the null character.
-  std::string key;
-  key.resize( _keyLength );
-  for ( int i = 0; i < _keyLength; i++ )
-    key[ i ] = rnd[ i ];
-  delete[] rnd;
+  // Define the key as a random number. It may contain the null character.
+  std::string key( _keyLength, '\0' );
+  Entropy::fill( &key[ 0 ], _keyLength );
 
   // Concatenate the key with the message.
   std::string output = key + input;
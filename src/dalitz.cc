@@ -8,6 +8,8 @@
 
 #include <cfit/function.hh>
 
+#include <atools/instrument.hh>
+#include <atools/sum.hh>
 #include <atools/utils.hh>
 
 #include <rtools/contour.hh>
@@ -48,7 +50,7 @@ Dalitz::Dalitz( const int& nbins, const PhaseSpace& ps )
 
   // Set all bin contents to zero.
   _binContent.resize( _nbins );
-  typedef std::vector< std::vector< double > >::iterator vIter;
+  typedef Rows::iterator vIter;
   for ( vIter row = _binContent.begin(); row != _binContent.end(); ++row )
     row->assign( _nbins, 0.0 );
 }
@@ -57,7 +59,28 @@ Dalitz::Dalitz( const int& nbins, const PhaseSpace& ps )
 
 void Dalitz::draw( const std::string& file )
 {
+  PlotContext context;
+  render( context, [ &file ]( TCanvas& canvas )
+          {
+            // Write all of these things to the latest open file.
+            canvas.Write();
+
+            // If any file name has been given, print the plot on a file.
+            if ( ! file.empty() )
+            {
+              INSTRUMENT_SCOPE( "TCanvas::Print" );
+              canvas.Print( file.c_str() );
+            }
+          } );
+}
+
+
+void Dalitz::render( PlotContext& context, const std::function< void( TCanvas& ) >& output ) const
+{
+  INSTRUMENT_SCOPE( "Dalitz::render" );
+
   TH2D data( _name.c_str(), _title.c_str(), _nbins, _min, _max, _nbins, _min, _max );
+  data.SetDirectory( 0 );
   data.SetStats( false );
 
   for ( int i = 0; i < _nbins; ++i )
@@ -65,55 +88,65 @@ void Dalitz::draw( const std::string& file )
       data.SetBinContent( 1 + i, 1 + j, _binContent[ i ][ j ] );
 
   // Plot the data histogram.
-  TCanvas canvas( _name.c_str(), _name.c_str(), 800, 800 );
+  TCanvas& canvas = context.canvas( _name, 0, 800, 800 );
   data.Draw( "col" );
 
   // Draw the upper and lower curves of the Dalitz contour.
   DalitzContour contour( _ps );
   contour.draw();
 
-  // Write all of these things to the latest open file.
-  canvas.Write();
+  output( canvas );
 
-  // If any file name has been given, print the plot on a file.
-  if ( ! file.empty() )
-    canvas.Print( file.c_str() );
+  // Clear the canvas while the objects drawn on it still exist.
+  canvas.Clear();
+  context.release();
 }
 
 
 void Dalitz::setData( const Dataset& data, const std::string& field1, const std::string& field2 )
 {
   // Set all bin contents to zero.
-  typedef std::vector< std::vector< double > >::iterator vIter;
+  typedef Rows::iterator vIter;
   for ( vIter row = _binContent.begin(); row != _binContent.end(); ++row )
     row->assign( _nbins, 0.0 );
 
   // Fill the bin contents with every event.
-  std::vector< double > values1 = data.values( field1 );
-  std::vector< double > values2 = data.values( field2 );
-  typedef std::vector< double >::const_iterator dIter;
-  dIter dat2 = values2.begin();
-  for ( dIter dat1 = values1.begin(); dat1 != values1.end(); ++dat1, ++dat2 )
-    _binContent[ bin( *dat1 ) ][ bin( *dat2 ) ]++;
+  fill( data.values( field1 ), data.values( field2 ) );
 }
 
 
 void Dalitz::addData( const Dataset& data, const std::string& field1, const std::string& field2 )
 {
   // Fill the bin contents with every event.
-  std::vector< double > values1 = data.values( field1 );
-  std::vector< double > values2 = data.values( field2 );
+  fill( data.values( field1 ), data.values( field2 ) );
+}
+
+
+// Add a set of events to the bin contents. Events outside the plot are ignored.
+void Dalitz::fill( const std::vector< double >& values1, const std::vector< double >& values2 )
+{
+  INSTRUMENT_SCOPE( "Dalitz::fill" );
+  INSTRUMENT_COUNT( eventsFilled, std::min( values1.size(), values2.size() ) );
+
   typedef std::vector< double >::const_iterator dIter;
   dIter dat2 = values2.begin();
-  for ( dIter dat1 = values1.begin(); dat1 != values1.end(); ++dat1, ++dat2 )
-    _binContent[ bin( *dat1 ) ][ bin( *dat2 ) ]++;
+  for ( dIter dat1 = values1.begin(); dat1 != values1.end() && dat2 != values2.end(); ++dat1, ++dat2 )
+  {
+    if ( *dat1 < _min || *dat2 < _min )
+      continue;
+
+    const int& bin1 = bin( *dat1 );
+    const int& bin2 = bin( *dat2 );
+    if ( bin1 < _nbins && bin2 < _nbins )
+      _binContent[ bin1 ][ bin2 ]++;
+  }
 }
 
 
 void Dalitz::setData( const Function& data, const std::string& field1, const std::string& field2 )
 {
   // Set all bin contents to zero.
-  typedef std::vector< std::vector< double > >::iterator vIter;
+  typedef Rows::iterator vIter;
   for ( vIter row = _binContent.begin(); row != _binContent.end(); ++row )
     row->assign( _nbins, 0.0 );
 
@@ -134,13 +167,12 @@ void Dalitz::setData( const Function& data, const std::string& field1, const std
 
 Dalitz* Dalitz::residuals( const PdfExpr& pdf, const std::string& field1, const std::string& field2, const std::string& field3 )
 {
+  INSTRUMENT_SCOPE( "Dalitz::residuals" );
+
   PdfExpr model( pdf );
 
   // Evaluate the number of data.
-  double integral = 0.0;
-  for ( int i = 0; i < _nbins; ++i )
-    for ( int j = 0; j < _nbins; ++j )
-      integral += _binContent[ i ][ j ];
+  const double& integral = Sum::serial( _nbins, [ this ]( const std::size_t& row ) { return Sum::of( _binContent[ row ] ); } );
 
   // Initialize some variables used in the evaluation of the pdf.
   double x = 0.0;
@@ -170,6 +202,7 @@ Dalitz* Dalitz::residuals( const PdfExpr& pdf, const std::string& field1, const
         vars.clear();
         std::transform( varMap.begin(), varMap.end(), std::back_inserter( vars ), []( const std::pair< std::string, double >& val ){ return val.second; } );
 
+        INSTRUMENT_COUNT( pdfEvaluations, 1 );
         double pdfval = integral * std::pow( ( _max - _min ) / double( _nbins ), 2 ) * model.evaluate( vars );
 
         dalitz->_binContent[ binX ][ binY ] = Utils::residual( _binContent[ binX ][ binY ], pdfval );
@@ -1,9 +1,12 @@
 
+#include <cmath>
 #include <algorithm>
 
 #include <cfit/dataset.hh>
 
 #include <atools/data.hh>
+#include <atools/instrument.hh>
+#include <atools/sum.hh>
 
 
 // Return quadrant number wrt a centroid.
@@ -40,62 +43,158 @@ const bool Datum::isQuadrant3( const std::pair< double, double > centroid ) cons
 
 
 
-const std::pair< double, double > Data::centroid( const std::vector< Datum >::const_iterator& begin,
-                                                  const std::vector< Datum >::const_iterator& end )
+template< class I >
+const std::pair< double, double > Data::centroid( const I& begin, const I& end )
 {
-  // Centroid position.
-  double xc = 0.0;
-  double yc = 0.0;
+  // Centroid position of the binned samples, with sums that do not depend on the number of threads.
+  const std::size_t& nData  = end - begin;
+  const double&      nTaken = count( begin, end );
+  const bool&        all    = ( _binned == allSamples );
+  const unsigned&    binned = _binned;
+
+  const double& xc = Sum::parallel( nData, [ & ]( const std::size_t& datum ) { return ( all || sample( begin[ datum ] ) == binned ) ? begin[ datum ].x() : 0.0; } ) / nTaken;
+  const double& yc = Sum::parallel( nData, [ & ]( const std::size_t& datum ) { return ( all || sample( begin[ datum ] ) == binned ) ? begin[ datum ].y() : 0.0; } ) / nTaken;
+
+  return std::make_pair( xc, yc );
+}
+
 
-  for ( std::vector< Datum >::const_iterator datum = begin; datum != end; ++datum )
+
+// Median of a coordinate of the binned samples of a range of data, which is reordered
+//    so that the data not above the median come first. Return the middle of the limits
+//    if there are no data of the binned samples.
+template< class I, class C >
+double Data::median( const I& begin, const I& end,
+                     const C& coordinate, const double& lo, const double& hi, I& middle ) const
+{
+  const auto& notAbove = [ &coordinate ]( const double& value ) { return [ &coordinate, value ]( const Datum& datum ) { return coordinate( datum ) <= value; }; };
+
+  // Move the data of the binned samples to the front.
+  I last = end;
+  if ( _binned != allSamples )
+    last = std::partition( begin, end, [ this ]( const auto& datum ) { return sample( datum ) == unsigned( _binned ); } );
+
+  if ( begin == last )
   {
-    xc += datum->x();
-    yc += datum->y();
+    middle = std::partition( begin, end, notAbove( 0.5 * ( lo + hi ) ) );
+    return 0.5 * ( lo + hi );
   }
 
-  const unsigned& nData = end - begin;
+  I nth = begin + ( last - begin - 1 ) / 2;
+  std::nth_element( begin, nth, last, [ &coordinate ]( const Datum& left, const Datum& right ) { return coordinate( left ) < coordinate( right ); } );
 
-  xc /= nData;
-  yc /= nData;
+  // Values equal to the median may lie on both sides of it. With a single sample, the
+  //    data before it are already in place.
+  const double median = coordinate( *nth );
+  middle = std::partition( ( last == end ) ? nth + 1 : begin, end, notAbove( median ) );
 
-  return std::make_pair( xc, yc );
+  return median;
 }
 
 
 
-void Data::adapt( const std::vector< Datum >::iterator& begin, const std::vector< Datum >::iterator& end,
-                  const double& xmin, const double& xmax, const double& ymin, const double& ymax,
-                  const unsigned& minEntries )
+template< class I >
+std::ptrdiff_t Data::count( const I& begin, const I& end ) const
 {
-  // Centroid position.
-  const std::pair< double, double >& cent = centroid( begin, end );
+  if ( _binned == allSamples )
+    return end - begin;
+
+  return std::count_if( begin, end, [ this ]( const auto& datum ) { return sample( datum ) == unsigned( _binned ); } );
+}
 
-  const double& xc = cent.first;
-  const double& yc = cent.second;
 
-  // Sort the range by quadrant wrt the centroid.
-  std::sort( begin, end, QuadrantSort( cent ) );
+template< class I >
+int Data::adapt( const I& begin, const I& end,
+                 const double& xmin, const double& xmax, const double& ymin, const double& ymax,
+                 const unsigned& depth )
+{
+  const int node = _tree.size();
+  _tree.push_back( Node() );
 
-  // Find the 3 positions of separation between the quadrants wrt the centroid.
-  std::vector< Datum >::iterator it1 = std::find_if( begin, end, std::bind2nd( std::mem_fun_ref( &Datum::isQuadrant1 ), cent ) );
-  std::vector< Datum >::iterator it2 = std::find_if( it1  , end, std::bind2nd( std::mem_fun_ref( &Datum::isQuadrant2 ), cent ) );
-  std::vector< Datum >::iterator it3 = std::find_if( it2  , end, std::bind2nd( std::mem_fun_ref( &Datum::isQuadrant3 ), cent ) );
+  double xc = 0.0;
+  double yc[ 2 ] = { 0.0, 0.0 };
 
-  // If any quadrant contains fewer elements than required by minEntries, create a bin.
-  if ( ( it1 - begin < minEntries ) ||
-       ( it2 - it1   < minEntries ) ||
-       ( it3 - it2   < minEntries ) ||
-       ( end - it3   < minEntries ) )
+  // Find the 3 positions of separation between the quadrants.
+  I it1, it2, it3;
+  if ( _split == medianSplit )
   {
-    _bins.push_back( Bin( xmin, xmax, ymin, ymax, end - begin ) );
-    return;
+    const auto& x = []( const Datum& datum ) { return datum.x(); };
+    const auto& y = []( const Datum& datum ) { return datum.y(); };
+
+    xc      = median( begin, end, x, xmin, xmax, it2 );
+    yc[ 0 ] = median( begin, it2, y, ymin, ymax, it1 );
+    yc[ 1 ] = median( it2  , end, y, ymin, ymax, it3 );
   }
+  else
+  {
+    // Centroid position.
+    const std::pair< double, double >& cent = centroid( begin, end );
+
+    xc = cent.first;
+    yc[ 0 ] = yc[ 1 ] = cent.second;
+
+    // Sort the range by quadrant wrt the centroid, and find where each quadrant starts.
+    std::sort( begin, end, QuadrantSort( cent ) );
 
-  // Recurse.
-  adapt( begin, it1, xmin, xc  , ymin, yc  , minEntries );
-  adapt( it1  , it2, xmin, xc  , yc  , ymax, minEntries );
-  adapt( it2  , it3, xc  , xmax, ymin, yc  , minEntries );
-  adapt( it3  , end, xc  , xmax, yc  , ymax, minEntries );
+    const auto& below = [ &cent ]( const unsigned& quadrant ) { return [ &cent, quadrant ]( const Datum& datum ) { return datum.quadrant( cent ) < quadrant; }; };
+
+    it1 = std::partition_point( begin, end, below( 1 ) );
+    it2 = std::partition_point( it1  , end, below( 2 ) );
+    it3 = std::partition_point( it2  , end, below( 3 ) );
+  }
+
+  // If any quadrant contains fewer elements than required by minEntries, or the
+  //    maximum depth has been reached, create a bin.
+  if ( ( count( begin, it1 ) < _minEntries ) ||
+       ( count( it1  , it2 ) < _minEntries ) ||
+       ( count( it2  , it3 ) < _minEntries ) ||
+       ( count( it3  , end ) < _minEntries ) ||
+       ( _maxDepth && depth + 1 >= _maxDepth ) )
+  {
+    _tree[ node ] = { xc, { yc[ 0 ], yc[ 1 ] }, { -1, -1, -1, -1 }, int( _bins.size() ) };
+    _bins.push_back( Bin( xmin, xmax, ymin, ymax, count( begin, end ) ) );
+
+    // Sum the weights of each sample while the range of the bin is at hand.
+    if ( _withJoint )
+    {
+      double sum [ 2 ] = { 0.0, 0.0 };
+      double sum2[ 2 ] = { 0.0, 0.0 };
+      for ( I datum = begin; datum != end; ++datum )
+      {
+        const double& w = weight( *datum );
+        sum [ sample( *datum ) ] += w;
+        sum2[ sample( *datum ) ] += w * w;
+      }
+
+      _joint.push_back( JointBin( Bin( xmin, xmax, ymin, ymax, sum[ dataSample ] ), sum2[ dataSample ], sum[ referenceSample ], sum2[ referenceSample ] ) );
+    }
+
+    return node;
+  }
+
+  // Recurse. The children are numbered as the quadrants.
+  const int& child0 = adapt( begin, it1, xmin, xc  , ymin   , yc[ 0 ], depth + 1 );
+  const int& child1 = adapt( it1  , it2, xmin, xc  , yc[ 0 ], ymax   , depth + 1 );
+  const int& child2 = adapt( it2  , it3, xc  , xmax, ymin   , yc[ 1 ], depth + 1 );
+  const int& child3 = adapt( it3  , end, xc  , xmax, yc[ 1 ], ymax   , depth + 1 );
+
+  _tree[ node ] = { xc, { yc[ 0 ], yc[ 1 ] }, { child0, child1, child2, child3 }, -1 };
+  return node;
+}
+
+
+
+const double JointBin::pull( const double& scale ) const
+{
+  const double& variance = content2() + scale * scale * reference2();
+  return ( variance > 0.0 ) ? ( content() - scale * reference() ) / std::sqrt( variance ) : 0.0;
+}
+
+
+const double JointBin::asymmetry( const double& scale ) const
+{
+  const double& total = content() + scale * reference();
+  return ( total > 0.0 ) ? ( content() - scale * reference() ) / total : 0.0;
 }
 
 
@@ -112,8 +211,11 @@ void Data::add( const double& x, const double y )
 
 void Data::add( const Dataset& data, const std::string& xField, const std::string& yField )
 {
+  INSTRUMENT_SCOPE( "Data::add" );
+
   std::vector< double > x = data.values( xField );
   std::vector< double > y = data.values( yField );
+  INSTRUMENT_COUNT( eventsFilled, std::min( x.size(), y.size() ) );
 
   std::transform( x.begin(), x.end(), y.begin(), std::back_inserter( _data ), Datum::mkDatum );
 
@@ -123,20 +225,121 @@ void Data::add( const Dataset& data, const std::string& xField, const std::strin
 
 
 
-std::vector< Bin > Data::adaptiveBins( const double& xmin, const double& xmax,
-                                       const double& ymin, const double& ymax,
-                                       const unsigned& minEntries )
+void Data::addReference( const double& x, const double& y, const double& weight )
+{
+  _reference.push_back( Datum( x, y ) );
+  _weights  .push_back( weight );
+
+  // Since new data have been added, it's not possible to reuse previously computed bins.
+  _binsDone = false;
+}
+
+
+
+void Data::addReference( const Dataset& data, const std::string& xField, const std::string& yField,
+                         const std::string& weightField )
+{
+  INSTRUMENT_SCOPE( "Data::addReference" );
+
+  const std::vector< double >& x = data.values( xField );
+  const std::vector< double >& y = data.values( yField );
+  const std::vector< double >& w = weightField.empty() ? std::vector< double >( x.size(), 1.0 ) : data.values( weightField );
+
+  const std::size_t nData = std::min( x.size(), std::min( y.size(), w.size() ) );
+  INSTRUMENT_COUNT( eventsFilled, nData );
+
+  std::transform( x.begin(), x.begin() + nData, y.begin(), std::back_inserter( _reference ), Datum::mkDatum );
+  _weights.insert( _weights.end(), w.begin(), w.begin() + nData );
+
+  // Since new data have been added, it's not possible to reuse previously computed bins.
+  _binsDone = false;
+}
+
+
+
+void Data::build( const double& xmin, const double& xmax, const double& ymin, const double& ymax,
+                  const unsigned& minEntries, const Sample& binned, const Split& split, const unsigned& maxDepth,
+                  const bool& withJoint )
 {
   // If the bins are already evaluated, don't recompute them.
-  if ( _binsDone )
-    return _bins;
+  if ( _binsDone && xmin == _xmin && xmax == _xmax && ymin == _ymin && ymax == _ymax &&
+       minEntries == _minEntries && binned == _binned && split == _split && maxDepth == _maxDepth &&
+       ( _withJoint || ! withJoint ) )
+    return;
+
+  INSTRUMENT_SCOPE( "Data::adaptiveBins" );
+
+  _xmin       = xmin;
+  _xmax       = xmax;
+  _ymin       = ymin;
+  _ymax       = ymax;
+  _minEntries = minEntries;
+  _binned     = binned;
+  _split      = split;
+  _maxDepth   = maxDepth;
+  _withJoint  = withJoint;
 
   _bins.clear();
-  adapt( _data.begin(), _data.end(), xmin, xmax, ymin, ymax, minEntries );
+  _joint.clear();
+  _tree.clear();
+  if ( _reference.empty() )
+    adapt( _data.begin(), _data.end(), xmin, xmax, ymin, ymax, 0 );
+  else
+  {
+    // Tag the data of both samples, so that they are reordered together.
+    TaggedDatums tagged;
+    tagged.reserve( _data.size() + _reference.size() );
+    for ( std::size_t datum = 0; datum < _data.size(); ++datum )
+      tagged.push_back( TaggedDatum( _data[ datum ], dataSample, datum ) );
+    for ( std::size_t datum = 0; datum < _reference.size(); ++datum )
+      tagged.push_back( TaggedDatum( _reference[ datum ], referenceSample, datum ) );
+
+    adapt( tagged.begin(), tagged.end(), xmin, xmax, ymin, ymax, 0 );
+  }
 
   // Mark the bins calculation as done, to avoid recomputing it unnecessarily.
   _binsDone = true;
+}
+
+
+
+std::vector< Bin > Data::adaptiveBins( const double& xmin, const double& xmax,
+                                       const double& ymin, const double& ymax,
+                                       const unsigned& minEntries,
+                                       const Split& split, const unsigned& maxDepth )
+{
+  build( xmin, xmax, ymin, ymax, minEntries, allSamples, split, maxDepth, false );
+
+  return std::vector< Bin >( _bins.begin(), _bins.end() );
+}
+
+
+
+std::vector< JointBin > Data::jointBins( const double& xmin, const double& xmax,
+                                         const double& ymin, const double& ymax,
+                                         const unsigned& minEntries, const Sample& binned,
+                                         const Split& split, const unsigned& maxDepth )
+{
+  build( xmin, xmax, ymin, ymax, minEntries, binned, split, maxDepth, true );
+
+  return std::vector< JointBin >( _joint.begin(), _joint.end() );
+}
+
+
+
+const int Data::findBin( const double& x, const double& y ) const
+{
+  if ( ! _binsDone || _tree.empty() || x < _xmin || x > _xmax || y < _ymin || y > _ymax )
+    return -1;
+
+  int node = 0;
+  while ( _tree[ node ].bin < 0 )
+  {
+    const Node& split = _tree[ node ];
+    const bool& upper = x > split.xc;
+    node = split.child[ 2 * upper + ( y > split.yc[ upper ] ) ];
+  }
 
-  return _bins;
+  return _tree[ node ].bin;
 }
 
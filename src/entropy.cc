@@ -0,0 +1,96 @@
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/random.h>
+
+#include <atools/entropy.hh>
+
+
+// Read random bytes from the kernel. Fall back to /dev/urandom if getrandom is not available.
+static void readRandom( char* buffer, std::size_t size )
+{
+  while ( size )
+  {
+    const ssize_t got = getrandom( buffer, size, 0 );
+    if ( got > 0 )
+    {
+      buffer += got;
+      size   -= got;
+      continue;
+    }
+
+    if ( got == -1 && errno == EINTR )
+      continue;
+
+    if ( got == -1 && errno == ENOSYS )
+      break;
+
+    std::exit( 1 );
+  }
+
+  if ( ! size )
+    return;
+
+  const int fd = open( "/dev/urandom", O_RDONLY );
+  if ( fd == -1 )
+    std::exit( 1 );
+
+  while ( size )
+  {
+    const ssize_t got = read( fd, buffer, size );
+    if ( got <= 0 && errno != EINTR )
+      std::exit( 1 );
+    if ( got > 0 )
+    {
+      buffer += got;
+      size   -= got;
+    }
+  }
+
+  close( fd );
+}
+
+
+// Pool of random bytes owned by each thread.
+struct EntropyPool
+{
+  char        bytes[ 4096 ];
+  std::size_t used = sizeof( bytes );
+  unsigned    forks = 0; // Number of forks of the process when it was filled.
+};
+
+static thread_local EntropyPool pool;
+
+// A forked process inherits the pool of the forking thread, so count the forks in the
+//    child to discard it there, and not hand out the same bytes as the parent.
+static unsigned forks = 0;
+static const int forkHandler = pthread_atfork( 0, 0, []() { ++forks; } );
+
+
+void Entropy::fill( char* buffer, const std::size_t& size )
+{
+  // Requests larger than the pool go straight to the kernel.
+  if ( size > sizeof( pool.bytes ) )
+  {
+    readRandom( buffer, size );
+    return;
+  }
+
+  if ( pool.used + size > sizeof( pool.bytes ) || pool.forks != forks )
+  {
+    readRandom( pool.bytes, sizeof( pool.bytes ) );
+    pool.used  = 0;
+    pool.forks = forks;
+  }
+
+  std::memcpy( buffer, pool.bytes + pool.used, size );
+
+  // Never hand out the same bytes twice.
+  std::memset( pool.bytes + pool.used, 0, size );
+  pool.used += size;
+}
@@ -33,6 +33,19 @@ void Graph::addPdf( const PdfExpr& pdf )
 
 
 void Graph::draw( const std::string& file ) const
+{
+  render( [ &file ]( TCanvas& canvas )
+          {
+            // Save the canvas in the latest open root file.
+            canvas.Write();
+
+            if ( file != "" )
+              canvas.Print( file.c_str() );
+          } );
+}
+
+
+void Graph::render( const std::function< void( TCanvas& ) >& output ) const
 {
   const double& step = ( _max - _min ) / double( _nbins );
 
@@ -64,11 +77,8 @@ void Graph::draw( const std::string& file ) const
   graph.SetLineWidth( 2.0 );
   graph.SetLineColor( kBlue );
 
-  // Draw the graph and save it in the latest open root file.
+  // Draw the graph and hand over the canvas.
   graph.Draw( "al" );
-  canvas.Write();
-
-  if ( file != "" )
-    canvas.Print( file.c_str() );
+  output( canvas );
 }
 
@@ -5,6 +5,8 @@
 #include <cfit/pdfmodel.hh>
 #include <cfit/pdfexpr.hh>
 
+#include <atools/instrument.hh>
+#include <atools/sum.hh>
 #include <atools/utils.hh>
 
 #include <rtools/hist.hh>
@@ -39,48 +41,58 @@ const double Hist::binCenter( const int& bin, const unsigned& nbins, const doubl
 // Auxiliary function to evaluate the pdf at a given point.
 const double Hist::pdf( const double& x ) const
 {
+  INSTRUMENT_COUNT( pdfEvaluations, 1 );
   return _pdf->evaluate( x );
 }
 
 
+// Take a column of a dataset, timing its materialization.
+static decltype( auto ) column( const Dataset& data, const std::string& field )
+{
+  INSTRUMENT_SCOPE( "Dataset::values" );
+  return data.values( field );
+}
+
+
 void Hist::setData( const Dataset& data, const std::string& field )
 {
+  INSTRUMENT_SCOPE( "Hist::setData" );
+
   _binContent.assign( _nbins, 0.0 );
   _allocatedData = true;
 
-  std::vector< double > values = data.values( field );
-  typedef std::vector< double >::const_iterator dIter;
-  unsigned binIdx; // Bin index.
-  for ( dIter dat = values.begin(); dat != values.end(); ++dat )
-  {
-    binIdx = bin( *dat );
-    if ( binIdx < 0 )
-      _underflow++;
-    else if ( binIdx > _nbins )
-      _overflow++;
-    else
-      _binContent[ binIdx ]++;
-  }
+  fill( column( data, field ) );
 }
 
 
 void Hist::addData( const Dataset& data, const std::string& field )
 {
+  INSTRUMENT_SCOPE( "Hist::addData" );
+
+  fill( column( data, field ) );
+}
+
+
+// Add a set of values to the bin contents.
+void Hist::fill( const std::vector< double >& values )
+{
+  INSTRUMENT_SCOPE( "Hist::fill" );
+  INSTRUMENT_COUNT( eventsFilled, values.size() );
+
   if ( ! _allocatedData )
   {
     _binContent.assign( _nbins, 0.0 );
     _allocatedData = true;
   }
 
-  std::vector< double > values = data.values( field );
   typedef std::vector< double >::const_iterator dIter;
-  unsigned binIdx; // Bin index.
+  int binIdx; // Bin index.
   for ( dIter dat = values.begin(); dat != values.end(); ++dat )
   {
     binIdx = bin( *dat );
-    if ( binIdx < 0 )
+    if ( *dat < _min )
       _underflow++;
-    else if ( binIdx > _nbins )
+    else if ( binIdx >= int( _nbins ) )
       _overflow++;
     else
       _binContent[ binIdx ]++;
@@ -111,34 +123,23 @@ void Hist::addPdf( const PdfExpr& pdf )
 
 
 
-// ALERT: this function does not deallocate the memory it allocates.
-TH1D* Hist::residuals( const TH1D& data, const TH1D* pdf ) const
+void Hist::residuals( const std::vector< double >& data, const std::vector< double >& pdf, std::vector< double >& resids ) const
 {
-  TH1D* residuals = new TH1D( ( "residuals_" + _name ).c_str(), "", _nbins, _min, _max );
-  double datum;
-  double pdfval;
+  resids.resize( _nbins );
   for ( unsigned bin = 0; bin < _nbins; ++bin )
-  {
-    // Root starts numbering from 1.
-    datum  = data .GetBinContent( bin + 1 );
-    pdfval = pdf ->GetBinContent( bin + 1 );
-
-    residuals->SetBinContent( bin + 1, Utils::residual( datum, pdfval ) );
-    residuals->SetBinError  ( bin + 1, 1.0 );
-  }
-
-  return residuals;
+    resids[ bin ] = Utils::residual( data[ bin ], pdf[ bin ] );
 }
 
 
-TH1D* Hist::project( const std::string& field, const double& area ) const
+void Hist::project( const std::string& field, const double& area, std::vector< double >& pdf ) const
 {
-  TH1D* pdf = new TH1D( ( "pdf_" + _name ).c_str(), _title.c_str(), _nbins, _min, _max );
+  INSTRUMENT_SCOPE( "Hist::project" );
+  INSTRUMENT_COUNT( pdfEvaluations, 2 * _nbins );
+
+  pdf.resize( _nbins );
 
   // Calculate the yield. Needed if pdf range has been restricted.
-  double yield = 0.0;
-  for ( unsigned x = 0; x < _nbins; ++x )
-    yield += _pdf->project( field, binCenter( x, _nbins, _min, _max ), _region );
+  double yield = Sum::serial( _nbins, [ & ]( const std::size_t& x ) { return _pdf->project( field, binCenter( x, _nbins, _min, _max ), _region ); } );
 
   // If yield is zero, then the pdf is zero at all evaluated points.
   //    Set yield to any value, just to avoid a nan. In such a case,
@@ -154,18 +155,14 @@ TH1D* Hist::project( const std::string& field, const double& area ) const
 
 
 
-    pdf->SetBinContent( x + 1, area * pdfval / yield );
+    pdf[ x ] = area * pdfval / yield;
   }
-
-  return pdf;
 }
 
 
 
-TH1D* Hist::getHist( const std::string& field, const double& area ) const
+void Hist::getHist( const std::string& field, const double& area, TH1D& pdf ) const
 {
-  TH1D* pdf = new TH1D( ( "pdf_" + _name ).c_str(), _title.c_str(), _nbins, _min, _max );
-
   std::vector< double > vals( 1 );
 
   const double&& yield = _pdf->yield();
@@ -177,56 +174,85 @@ TH1D* Hist::getHist( const std::string& field, const double& area ) const
 
     double yVal = _pdf->evaluate( vals );
 
-    pdf->SetBinContent( x + 1, area * yVal * ( _max - _min ) / double( _nbins * yield ) );
+    pdf.SetBinContent( x + 1, area * yVal * ( _max - _min ) / double( _nbins * yield ) );
   }
-
-  return pdf;
 }
 
 
 
 void Hist::draw( const std::string& file ) const
 {
-  TH1D data( ( "data_" + _name ).c_str(), _title.c_str(), _nbins, _min, _max );
-  int bin = 0;
-  double area = 0.0;
-  typedef std::vector< double >::const_iterator bIter;
-  for ( bIter val = _binContent.begin(); val != _binContent.end(); ++val )
-  {
-    area += *val;
-    data.SetBinContent( 1 + bin++, *val );
-  }
+  PlotContext context;
+  draw( context, file );
+}
+
+
+void Hist::draw( PlotContext& context, const std::string& file ) const
+{
+  render( frame(), context, [ &file ]( TCanvas& canvas )
+          {
+            // Save the canvas.
+            canvas.Write();
+
+            if ( file != "" )
+            {
+              INSTRUMENT_SCOPE( "TCanvas::Print" );
+              canvas.Print( file.c_str() );
+            }
+          } );
+}
+
+
+const Hist::Frame Hist::frame() const
+{
+  INSTRUMENT_SCOPE( "Hist::frame" );
+
+  Frame frame;
+
+  frame.data.assign( _binContent.begin(), _binContent.end() );
+  frame.data.resize( _nbins, 0.0 );
+
+  double area = Sum::of( frame.data );
 
   // Set unit area for plots of pdfs without data.
   if ( area == 0.0 )
     area = 1.0;
 
-  data.SetBinErrorOption( TH1::kPoisson );
+  project  ( _field, area, frame.pdf );
+  residuals( frame.data, frame.pdf, frame.resids );
+
+  return frame;
+}
 
-  // ALERT: this is an allocation. This histogram has to be deallocated in this function.
-  TH1D* pdf = project( _field, area );
 
-  // ALERT: this is an allocation. This histogram has to be deallocated in this function.
-  TH1D* resids = residuals( data, pdf );
+void Hist::render( const Frame& frame, PlotContext& context, const std::function< void( TCanvas& ) >& output ) const
+{
+  INSTRUMENT_SCOPE( "Hist::render" );
+
+  TH1D& data   = context.hist( "data"     , "data_"      + _name, _title, _nbins, _min, _max );
+  TH1D& pdf    = context.hist( "pdf"      , "pdf_"       + _name, _title, _nbins, _min, _max );
+  TH1D& resids = context.hist( "residuals", "residuals_" + _name, ""    , _nbins, _min, _max );
+
+  // Root starts numbering from 1.
+  for ( unsigned bin = 0; bin < _nbins; ++bin )
+  {
+    data  .SetBinContent( bin + 1, frame.data  [ bin ] );
+    pdf   .SetBinContent( bin + 1, frame.pdf   [ bin ] );
+    resids.SetBinContent( bin + 1, frame.resids[ bin ] );
+    resids.SetBinError  ( bin + 1, 1.0 );
+  }
+
+  data.SetBinErrorOption( TH1::kPoisson );
 
   // Prepare the canvas to draw the histograms.
-  TCanvas canvas( _name.c_str() );
-  if ( _withResiduals )
-    canvas.Divide( 1, 2, 0.1, 0.1 );
-  else
-    canvas.Divide( 1, 1, 0.1, 0.1 );
+  TCanvas& canvas = context.canvas( _name, _withResiduals ? 2 : 1 );
 
   // Draw everything on the canvas.
-  draw( canvas, data, resids, pdf );
-
-  // Save the canvas.
-  canvas.Write();
+  draw( canvas, data, &resids, &pdf );
 
-  if ( file != "" )
-    canvas.Print( file.c_str() );
+  output( canvas );
 
-  delete resids;
-  delete pdf;
+  context.release();
 }
 
 
@@ -236,8 +262,7 @@ void Hist::draw( const TCanvas& canvas, TH1D& data, TH1D* resids, TH1D* pdf ) co
   TPad* padHisto = (TPad*) canvas.GetListOfPrimitives()->At( 0 );
   TPad* padResid = (TPad*) canvas.GetListOfPrimitives()->At( 1 ); // Returns 0 if it does not exist.
 
-  if ( _logscale )
-    padHisto->SetLogy();
+  padHisto->SetLogy( _logscale );
 
   // Do the cosmetics.
   cosmeticsData  ( data   );
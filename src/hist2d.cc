@@ -1,4 +1,6 @@
 
+#include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <algorithm>
 #include <functional>
@@ -9,8 +11,12 @@
 #include <root/TH2D.h>
 #include <root/TCanvas.h>
 #include <root/TColor.h>
+#include <root/TROOT.h>
+
+#include <atools/sum.hh>
 
 #include <rtools/hist2d.hh>
+#include <rtools/png.hh>
 
 
 
@@ -31,6 +37,35 @@ void Hist2D::insert( const std::vector< Bin >& bins )
 
 
 
+// Factor that normalizes the reference sample of two-sample bins to the data sample.
+static double referenceScale( const std::vector< JointBin >& bins )
+{
+  const double& content   = Sum::serial( bins.size(), [ &bins ]( const std::size_t& bin ) { return bins[ bin ].content();   } );
+  const double& reference = Sum::serial( bins.size(), [ &bins ]( const std::size_t& bin ) { return bins[ bin ].reference(); } );
+
+  return ( reference > 0.0 ) ? content / reference : 0.0;
+}
+
+
+
+void Hist2D::insertPulls( const std::vector< JointBin >& bins )
+{
+  const double& scale = referenceScale( bins );
+  for ( std::vector< JointBin >::const_iterator bin = bins.begin(); bin != bins.end(); ++bin )
+    push_back( Bin( bin->xlo(), bin->xhi(), bin->ylo(), bin->yhi(), bin->pull( scale ) ) );
+}
+
+
+
+void Hist2D::insertAsymmetries( const std::vector< JointBin >& bins )
+{
+  const double& scale = referenceScale( bins );
+  for ( std::vector< JointBin >::const_iterator bin = bins.begin(); bin != bins.end(); ++bin )
+    push_back( Bin( bin->xlo(), bin->xhi(), bin->ylo(), bin->yhi(), bin->asymmetry( scale ) ) );
+}
+
+
+
 void Hist2D::draw( const std::string& filename, const bool& withCol ) const
 {
   std::vector< double > x( 5 );
@@ -87,3 +122,48 @@ void Hist2D::draw( const std::string& filename, const bool& withCol ) const
     canvas.Print( filename.c_str() );
 }
 
+
+
+bool Hist2D::drawRaster( const std::string& filename, const unsigned& width, const unsigned& height ) const
+{
+  // Translate the palette to pixel values once.
+  std::vector< std::uint32_t > palette( _nColor, 0xff000000 );
+  for ( unsigned color = 0; color < _nColor; ++color )
+  {
+    const TColor* rootColor = gROOT->GetColor( _color[ color ] );
+    if ( rootColor )
+      palette[ color ] = 0xff000000 | ( std::uint32_t( 255 * rootColor->GetRed()   + .5 ) << 16 )
+                                    | ( std::uint32_t( 255 * rootColor->GetGreen() + .5 ) <<  8 )
+                                    |   std::uint32_t( 255 * rootColor->GetBlue()  + .5 );
+  }
+
+  std::vector< std::uint32_t > pixels( std::size_t( width ) * height, 0xffffffff );
+
+  const double& dx = ( _xmax - _xmin ) / width;
+  const double& dy = ( _ymax - _ymin ) / height;
+
+  // Pixel that contains a coordinate, counting from the left and from the top. A bin
+  //    covers the pixels whose centers it contains, so contiguous bins never overlap.
+  auto column = [&]( const double& x ) { return long( std::ceil( ( x     - _xmin ) / dx - .5 ) ); };
+  auto row    = [&]( const double& y ) { return long( std::ceil( ( _ymax - y     ) / dy - .5 ) ); };
+  auto clamp  = []( const long& pos, const unsigned& size ) { return std::size_t( std::min< long >( std::max< long >( pos, 0 ), size ) ); };
+
+  for ( std::vector< Bin >::const_iterator bin = _bins.begin(); bin != _bins.end(); ++bin )
+  {
+    // Calculate the color from the bin content.
+    unsigned color = 0;
+    if ( _zmax > _zmin )
+      color = std::min( _nColor - 1, unsigned( _nColor * ( bin->content() - _zmin ) / ( _zmax - _zmin ) ) );
+
+    const std::size_t& colLo = clamp( column( bin->xlo() ), width  );
+    const std::size_t& colHi = clamp( column( bin->xhi() ), width  );
+    const std::size_t& rowLo = clamp( row   ( bin->yhi() ), height );
+    const std::size_t& rowHi = clamp( row   ( bin->ylo() ), height );
+
+    for ( std::size_t line = rowLo; line < rowHi; ++line )
+      std::fill( pixels.begin() + line * width + colLo, pixels.begin() + line * width + colHi, palette[ color ] );
+  }
+
+  return Png::write( filename, width, height, pixels );
+}
+
@@ -30,6 +30,11 @@ Lines::Lines( const TH1D* resid )
 
 void Lines::draw()
 {
+  // Let the pad delete the lines when it is cleared.
+  midLine->SetBit( kCanDelete );
+  uppLine->SetBit( kCanDelete );
+  lowLine->SetBit( kCanDelete );
+
   midLine->Draw( "same" );
   uppLine->Draw( "same" );
   lowLine->Draw( "same" );
@@ -0,0 +1,126 @@
+
+#include <string>
+#include <string_view>
+
+#include <atools/blind.hh>
+#include <atools/parse.hh>
+#include <atools/parspec.hh>
+
+
+// Characters that separate tokens. Commas and asterisks are allowed in the limits,
+//    e.g. "L( *0, 5 )", where the asterisk indicates a result at the limit.
+static bool isSeparator( const char& ch )
+{
+  return Parse::isSpace( ch ) || ch == ',' || ch == '*';
+}
+
+
+// Cursor over a parameter specification.
+class ParSpecScanner
+{
+private:
+  std::string_view _info;
+  std::size_t      _pos;
+
+public:
+  ParSpecScanner( const std::string_view& info ) : _info( info ), _pos( 0 ) {}
+
+  const std::size_t& position() const { return _pos; }
+
+  bool skip()
+  {
+    while ( _pos < _info.size() && isSeparator( _info[ _pos ] ) )
+      ++_pos;
+
+    return _pos < _info.size();
+  }
+
+  // Return the next token. An opening parenthesis always starts a new token.
+  std::string_view token()
+  {
+    skip();
+    const std::size_t begin = _pos;
+    while ( _pos < _info.size() && ! isSeparator( _info[ _pos ] ) && ( _pos == begin || _info[ _pos ] != '(' ) )
+      ++_pos;
+
+    return _info.substr( begin, _pos - begin );
+  }
+
+  // Consume the given character if it is the next one.
+  bool accept( const char& ch )
+  {
+    if ( ! skip() || _info[ _pos ] != ch )
+      return false;
+
+    ++_pos;
+    return true;
+  }
+
+  // Read a number, which may be directly followed by other characters, such as ")".
+  double number( const char* what )
+  {
+    skip();
+    double value = 0.0;
+    const std::size_t& length = Parse::number( _info.substr( _pos ), value );
+    if ( ! length )
+      throw ParSpecException( std::string( "Expected " ) + what + " at position " + std::to_string( _pos ) + ".", _pos );
+
+    _pos += length;
+    return value;
+  }
+};
+
+
+const ParSpec ParSpec::parse( const std::string_view& info )
+{
+  ParSpec spec;
+  ParSpecScanner scanner( info );
+
+  while ( scanner.skip() )
+  {
+    const std::size_t start = scanner.position();
+    const std::string_view& token = scanner.token();
+
+    if ( token == "C" )
+      spec._fixed = true;
+    else if ( token == "B" )
+      spec._blind = true;
+    else if ( token == "L" )
+    {
+      if ( ! scanner.accept( '(' ) )
+        throw ParSpecException( "Expected ( after L at position " + std::to_string( scanner.position() ) + ".", scanner.position() );
+
+      spec._loLimit = scanner.number( "lower limit" );
+      spec._upLimit = scanner.number( "upper limit" );
+      spec._limited = true;
+      scanner.accept( ')' );
+    }
+    else if ( token == "+-" )
+    {
+      // Parameters without error are printed as "+- no".
+      const ParSpecScanner saved = scanner;
+      if ( scanner.token() != "no" )
+      {
+        scanner = saved;
+        spec._error = scanner.number( "error" );
+      }
+    }
+    else if ( token == "-" )
+    {
+      spec._value = -scanner.number( "value" );
+      spec._set   = true;
+    }
+    else if ( ! spec._set )
+    {
+      // The value is either a number or a blinded string.
+      if ( ! Parse::number( token, spec._value ) )
+        spec._value = Blind( 4 ).unblind< double >( std::string( token ) );
+      spec._set = true;
+    }
+    else if ( token != ")" )
+      throw ParSpecException( "Don't know what to do with token " + std::string( token ) +
+                              " at position " + std::to_string( start ) + ".", start );
+  }
+
+  return spec;
+}
@@ -0,0 +1,114 @@
+
+#include <root/TList.h>
+#include <root/TPad.h>
+
+#include <rtools/plotcontext.hh>
+
+
+PlotContext::~PlotContext()
+{
+  // Delete the canvases before the histograms drawn on them.
+  release();
+  _freeCanvases.clear();
+  _freeHists   .clear();
+}
+
+
+TH1D& PlotContext::hist( const std::string& role, const std::string& name, const std::string& title,
+                         const int& nbins, const double& min, const double& max )
+{
+  const HistKey key( role, nbins, min, max );
+
+  std::vector< std::unique_ptr< TH1D > >& free = _freeHists[ key ];
+  std::unique_ptr< TH1D > hist;
+  if ( free.empty() )
+  {
+    // Do not let root register the histogram, not even temporarily.
+    const bool status = TH1::AddDirectoryStatus();
+    TH1::AddDirectory( false );
+    hist.reset( new TH1D( name.c_str(), title.c_str(), nbins, min, max ) );
+    TH1::AddDirectory( status );
+  }
+  else
+  {
+    hist = std::move( free.back() );
+    free.pop_back();
+
+    hist->Reset();
+    hist->SetName ( name .c_str() );
+    hist->SetTitle( title.c_str() );
+
+    // Cosmetics may scale the axis attributes, so they have to start from the defaults.
+    hist->GetXaxis()->ResetAttAxis( "X" );
+    hist->GetYaxis()->ResetAttAxis( "Y" );
+  }
+
+  hist->SetDirectory( 0 );
+
+  _usedHists.emplace_back( key, std::move( hist ) );
+  return *_usedHists.back().second;
+}
+
+
+TCanvas& PlotContext::canvas( const std::string& name, const int& nPads, const int& width, const int& height )
+{
+  std::vector< std::unique_ptr< TCanvas > >& free = _freeCanvases[ nPads ];
+  std::unique_ptr< TCanvas > canvas;
+  if ( free.empty() )
+  {
+    // Root deletes any existing canvas with the same name, so use a name of our own
+    //    and rename the canvas afterwards.
+    const std::string& id = "plotcontext_" + std::to_string( _nCanvases++ );
+    if ( width && height )
+      canvas.reset( new TCanvas( id.c_str(), name.c_str(), width, height ) );
+    else
+      canvas.reset( new TCanvas( id.c_str(), name.c_str() ) );
+
+    if ( nPads )
+      canvas->Divide( 1, nPads, 0.1, 0.1 );
+  }
+  else
+  {
+    canvas = std::move( free.back() );
+    free.pop_back();
+
+    if ( width && height )
+      canvas->SetCanvasSize( width, height );
+  }
+
+  canvas->SetName ( name.c_str() );
+  canvas->SetTitle( name.c_str() );
+
+  // Clear the pads, but keep the division of the canvas.
+  if ( nPads )
+  {
+    TList* pads = canvas->GetListOfPrimitives();
+    for ( int pad = 0; pad < pads->GetSize(); ++pad )
+    {
+      TPad* subpad = (TPad*) pads->At( pad );
+      subpad->Clear();
+      subpad->SetLogx( false );
+      subpad->SetLogy( false );
+    }
+  }
+  else
+    canvas->Clear();
+
+  // Make it the current pad, as a new canvas would be.
+  canvas->cd();
+
+  _usedCanvases.emplace_back( nPads, std::move( canvas ) );
+  return *_usedCanvases.back().second;
+}
+
+
+void PlotContext::release()
+{
+  for ( std::pair< int, std::unique_ptr< TCanvas > >& canvas : _usedCanvases )
+    _freeCanvases[ canvas.first ].push_back( std::move( canvas.second ) );
+  _usedCanvases.clear();
+
+  for ( std::pair< HistKey, std::unique_ptr< TH1D > >& hist : _usedHists )
+    _freeHists[ hist.first ].push_back( std::move( hist.second ) );
+  _usedHists.clear();
+}
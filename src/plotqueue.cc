@@ -0,0 +1,227 @@
+
+#include <memory>
+#include <thread>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <root/TFile.h>
+#include <root/TROOT.h>
+
+#include <atools/instrument.hh>
+#include <atools/scheduler.hh>
+
+#include <rtools/adaptivedalitz.hh>
+#include <rtools/dalitz.hh>
+#include <rtools/hist.hh>
+#include <rtools/plotqueue.hh>
+
+
+// Name of the key of the canvas of a job in the temporary files.
+static const std::string jobKey( const std::size_t& job )
+{
+  return "plotqueue_job_" + std::to_string( job );
+}
+
+
+void PlotQueue::add( const Hist& hist, const std::string& file )
+{
+  std::shared_ptr< Hist::Frame > frame( new Hist::Frame );
+
+  Job job;
+  job.source  = &hist;
+  job.bin     = []() {};
+  job.compute = [ &hist, frame ]() { *frame = hist.frame(); };
+  job.render  = [ &hist, frame ]( PlotContext& context, const Output& output ) { hist.render( *frame, context, output ); };
+  job.file    = file;
+
+  _jobs.push_back( job );
+}
+
+
+void PlotQueue::add( const Dalitz& dalitz, const std::string& file )
+{
+  // The bin contents of a Dalitz plot are already known.
+  Job job;
+  job.source  = &dalitz;
+  job.bin     = []() {};
+  job.compute = []() {};
+  job.render  = [ &dalitz ]( PlotContext& context, const Output& output ) { dalitz.render( context, output ); };
+  job.file    = file;
+
+  _jobs.push_back( job );
+}
+
+
+void PlotQueue::add( AdaptiveDalitz& dalitz, const std::string& file )
+{
+  std::shared_ptr< std::vector< Bin > > bins( new std::vector< Bin > );
+
+  // Bin the data of each plot only once, since the binning modifies it.
+  const bool& queued = std::any_of( _jobs.begin(), _jobs.end(), [ &dalitz ]( const Job& job ) { return job.source == &dalitz; } );
+
+  Job job;
+  job.source  = &dalitz;
+  job.bin     = queued ? std::function< void() >( []() {} ) : std::function< void() >( [ &dalitz ]() { dalitz.binData(); } );
+  job.compute = [ &dalitz, bins ]() { *bins = dalitz.frame(); };
+  job.render  = [ &dalitz, bins ]( PlotContext& context, const Output& output ) { dalitz.render( *bins, context, output ); };
+  job.file    = file;
+
+  _jobs.push_back( job );
+}
+
+
+void PlotQueue::compute()
+{
+  INSTRUMENT_SCOPE( "PlotQueue::compute" );
+
+  // Bin the data of one job per task.
+  Scheduler::parallel_for( 0, _jobs.size(), [ this ]( const std::size_t& first, const std::size_t& last )
+                           {
+                             for ( std::size_t job = first; job < last; ++job )
+                               _jobs[ job ].bin();
+                           }, 1 );
+
+  // Evaluate the pdfs in this thread only.
+  for ( Job& job : _jobs )
+    job.compute();
+}
+
+
+// Render a job in this process, writing the canvas to the target directory.
+void PlotQueue::render( const std::size_t& job, PlotContext& context, TDirectory& target )
+{
+  const std::string& file = _jobs[ job ].file;
+  _jobs[ job ].render( context, [ &target, &file ]( TCanvas& canvas )
+                       {
+                         target.cd();
+                         canvas.Write();
+
+                         if ( ! file.empty() )
+                         {
+                           INSTRUMENT_SCOPE( "TCanvas::Print" );
+                           canvas.Print( file.c_str() );
+                         }
+                       } );
+}
+
+
+int PlotQueue::worker( const unsigned& worker, const unsigned& nWorkers, const std::string& file )
+{
+  gROOT->SetBatch( true );
+
+  TFile output( file.c_str(), "RECREATE" );
+  if ( output.IsZombie() )
+    return 1;
+
+  PlotContext context;
+  for ( std::size_t job = worker; job < _jobs.size(); job += nWorkers )
+  {
+    const std::string& print = _jobs[ job ].file;
+    const std::string& key   = jobKey( job );
+    _jobs[ job ].render( context, [ &output, &print, &key ]( TCanvas& canvas )
+                         {
+                           output.cd();
+                           canvas.Write( key.c_str() );
+
+                           if ( ! print.empty() )
+                           {
+                             INSTRUMENT_SCOPE( "TCanvas::Print" );
+                             canvas.Print( print.c_str() );
+                           }
+                         } );
+  }
+
+  output.Close();
+  return 0;
+}
+
+
+void PlotQueue::run()
+{
+  const std::size_t& nJobs = _jobs.size();
+  if ( ! nJobs )
+    return;
+
+  TDirectory* target = gDirectory;
+
+  compute();
+
+  unsigned nWorkers = _nProcesses ? _nProcesses : std::max( 1u, std::thread::hardware_concurrency() );
+  nWorkers = std::min< std::size_t >( nWorkers, nJobs );
+
+  // Fork the workers. The threads of the Scheduler are still alive, idle, in this
+  //    process, but the workers only have the forking thread, and the Scheduler
+  //    starts a new pool in them if they use it.
+  const char* tmpdir = std::getenv( "TMPDIR" );
+  const std::string& prefix = std::string( tmpdir ? tmpdir : "/tmp" ) + "/plotqueue_" + std::to_string( getpid() ) + "_";
+
+  std::vector< std::string > files( nWorkers );
+  std::vector< pid_t >       pids ( nWorkers, -1 );
+  if ( nWorkers > 1 )
+    for ( unsigned worker = 0; worker < nWorkers; ++worker )
+    {
+      files[ worker ] = prefix + std::to_string( worker ) + ".root";
+
+      pids[ worker ] = fork();
+      if ( pids[ worker ] == 0 )
+      {
+        // Leave without running any destructor or exit handler of the parent.
+        const int& status = this->worker( worker, nWorkers, files[ worker ] );
+        INSTRUMENT_DUMP();
+        std::cout.flush();
+        _exit( status );
+      }
+    }
+
+  // Open the files of the workers that finished successfully.
+  std::vector< std::unique_ptr< TFile > > inputs( nWorkers );
+  for ( unsigned worker = 0; worker < nWorkers; ++worker )
+  {
+    if ( pids[ worker ] <= 0 )
+      continue;
+
+    int status = 0;
+    waitpid( pids[ worker ], &status, 0 );
+    if ( WIFEXITED( status ) && WEXITSTATUS( status ) == 0 )
+    {
+      inputs[ worker ].reset( TFile::Open( files[ worker ].c_str(), "READ" ) );
+      if ( inputs[ worker ] && inputs[ worker ]->IsZombie() )
+        inputs[ worker ].reset();
+    }
+    else
+      std::cerr << "Plot worker " << worker << " failed. Its plots are drawn by the main process." << std::endl;
+  }
+
+  // Copy the canvases in the order of the jobs. Draw here those that no worker produced.
+  PlotContext context;
+  for ( std::size_t job = 0; job < nJobs; ++job )
+  {
+    TFile* input = inputs[ job % nWorkers ].get();
+    TObject* canvas = input ? input->Get( jobKey( job ).c_str() ) : 0;
+    if ( canvas )
+    {
+      target->cd();
+      canvas->Write();
+      delete canvas;
+    }
+    else
+      render( job, context, *target );
+  }
+
+  for ( unsigned worker = 0; worker < nWorkers; ++worker )
+  {
+    if ( inputs[ worker ] )
+      inputs[ worker ]->Close();
+    inputs[ worker ].reset();
+
+    if ( ! files[ worker ].empty() )
+      unlink( files[ worker ].c_str() );
+  }
+
+  target->cd();
+  _jobs.clear();
+}
@@ -0,0 +1,140 @@
+
+#include <iostream>
+
+#include <root/TImage.h>
+
+#include <atools/instrument.hh>
+
+#include <rtools/plotsink.hh>
+#include <rtools/png.hh>
+
+
+static bool isPng( const std::string& file )
+{
+  return file.size() > 4 && file.compare( file.size() - 4, 4, ".png" ) == 0;
+}
+
+
+PlotSink::PlotSink( TDirectory* target, const std::string& pdf )
+  : _target( target ? target : gDirectory ), _pdf( pdf ), _busy( false ), _stop( false )
+{
+  _encoder = std::thread( &PlotSink::encode, this );
+}
+
+
+PlotSink::~PlotSink()
+{
+  flush();
+
+  {
+    std::lock_guard< std::mutex > lock( _lock );
+    _stop = true;
+  }
+  _wakeup.notify_one();
+  _encoder.join();
+}
+
+
+// Encode the queued images until the sink is destroyed.
+void PlotSink::encode()
+{
+  std::unique_lock< std::mutex > lock( _lock );
+  while ( true )
+  {
+    _wakeup.wait( lock, [ this ]() { return _stop || ! _images.empty(); } );
+    if ( _images.empty() )
+      return;
+
+    Image image = std::move( _images.front() );
+    _images.pop_front();
+    _busy = true;
+
+    lock.unlock();
+    INSTRUMENT_SCOPE( "Png::write" );
+    if ( ! Png::write( image.file, image.width, image.height, image.argb ) )
+      std::cerr << "Cannot write image " << image.file << "." << std::endl;
+    lock.lock();
+
+    _busy = false;
+    _idle.notify_all();
+  }
+}
+
+
+void PlotSink::add( TCanvas& canvas, const std::string& file )
+{
+  // Capture the pixels now, while the canvas is drawn, and leave the encoding to the background thread.
+  std::string print = file;
+  if ( isPng( file ) )
+  {
+    std::unique_ptr< TImage > image( TImage::Create() );
+    if ( image )
+    {
+      image->FromPad( &canvas );
+
+      Image pixels;
+      pixels.file   = file;
+      pixels.width  = image->GetWidth();
+      pixels.height = image->GetHeight();
+
+      const UInt_t* argb = image->GetArgbArray();
+      if ( argb )
+      {
+        pixels.argb.assign( argb, argb + std::size_t( pixels.width ) * pixels.height );
+
+        {
+          std::lock_guard< std::mutex > lock( _lock );
+          _images.push_back( std::move( pixels ) );
+        }
+        _wakeup.notify_one();
+        print.clear();
+      }
+    }
+  }
+
+  _canvases.emplace_back( std::unique_ptr< TCanvas >( (TCanvas*) canvas.Clone() ), print );
+}
+
+
+const std::function< void( TCanvas& ) > PlotSink::output( const std::string& file )
+{
+  return [ this, file ]( TCanvas& canvas ) { add( canvas, file ); };
+}
+
+
+void PlotSink::flush()
+{
+  if ( ! _canvases.empty() )
+  {
+    INSTRUMENT_SCOPE( "PlotSink::flush" );
+
+    TDirectory* current = gDirectory;
+
+    // Write all the canvases at once.
+    _target->cd();
+    for ( std::pair< std::unique_ptr< TCanvas >, std::string >& canvas : _canvases )
+      canvas.first->Write();
+
+    // Print them as the pages of a single document.
+    if ( ! _pdf.empty() )
+    {
+      _canvases.front().first->Print( ( _pdf + "[" ).c_str() );
+      for ( std::pair< std::unique_ptr< TCanvas >, std::string >& canvas : _canvases )
+        canvas.first->Print( _pdf.c_str() );
+      _canvases.back().first->Print( ( _pdf + "]" ).c_str() );
+    }
+
+    for ( std::pair< std::unique_ptr< TCanvas >, std::string >& canvas : _canvases )
+      if ( ! canvas.second.empty() )
+        canvas.first->Print( canvas.second.c_str() );
+
+    _canvases.clear();
+
+    if ( current )
+      current->cd();
+  }
+
+  // Wait for the pending images.
+  std::unique_lock< std::mutex > lock( _lock );
+  _idle.wait( lock, [ this ]() { return _images.empty() && ! _busy; } );
+}
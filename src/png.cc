@@ -0,0 +1,74 @@
+
+#include <fstream>
+
+#include <zlib.h>
+
+#include <rtools/png.hh>
+
+
+// Append a 32 bit integer in network byte order.
+static void putUInt( std::string& out, const std::uint32_t& value )
+{
+  out.push_back( char( value >> 24 ) );
+  out.push_back( char( value >> 16 ) );
+  out.push_back( char( value >>  8 ) );
+  out.push_back( char( value       ) );
+}
+
+
+// Append a chunk, with its length and its checksum.
+static void putChunk( std::string& out, const char* type, const std::string& data )
+{
+  putUInt( out, data.size() );
+
+  const std::size_t& begin = out.size();
+  out.append( type, 4 );
+  out.append( data );
+
+  putUInt( out, crc32( crc32( 0, Z_NULL, 0 ), (const Bytef*) out.data() + begin, out.size() - begin ) );
+}
+
+
+bool Png::write( const std::string& file, const unsigned& width, const unsigned& height,
+                 const std::vector< std::uint32_t >& argb )
+{
+  if ( ! width || ! height || argb.size() < std::size_t( width ) * height )
+    return false;
+
+  // Each row starts with its filter type, which is always none.
+  const std::size_t& rowSize = 1 + 3 * std::size_t( width );
+  std::string raw( rowSize * height, '\0' );
+  for ( unsigned row = 0; row < height; ++row )
+  {
+    char*                pixel = &raw[ row * rowSize + 1 ];
+    const std::uint32_t* input = argb.data() + std::size_t( row ) * width;
+    for ( unsigned col = 0; col < width; ++col )
+    {
+      *pixel++ = char( input[ col ] >> 16 );
+      *pixel++ = char( input[ col ] >>  8 );
+      *pixel++ = char( input[ col ]       );
+    }
+  }
+
+  uLongf size = compressBound( raw.size() );
+  std::string compressed( size, '\0' );
+  if ( compress2( (Bytef*) &compressed[ 0 ], &size, (const Bytef*) raw.data(), raw.size(), Z_DEFAULT_COMPRESSION ) != Z_OK )
+    return false;
+  compressed.resize( size );
+
+  // Width, height, bit depth, colour type (RGB), compression, filter and interlace methods.
+  std::string header;
+  putUInt( header, width  );
+  putUInt( header, height );
+  header += std::string( "\x08\x02\x00\x00\x00", 5 );
+
+  std::string out( "\x89PNG\r\n\x1a\n", 8 );
+  putChunk( out, "IHDR", header     );
+  putChunk( out, "IDAT", compressed );
+  putChunk( out, "IEND", ""         );
+
+  std::ofstream output( file.c_str(), std::ios::binary | std::ios::trunc );
+  output.write( out.data(), out.size() );
+
+  return bool( output );
+}
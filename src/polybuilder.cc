@@ -0,0 +1,80 @@
+
+#include <cmath>
+#include <algorithm>
+
+#include <rtools/polybuilder.hh>
+
+
+// Do not let the grid grow without limit for very fine binnings.
+static const int maxCells = 512;
+
+
+// Median of a set of values, which is reordered.
+static double median( std::vector< double >& values )
+{
+  std::vector< double >::iterator middle = values.begin() + values.size() / 2;
+  std::nth_element( values.begin(), middle, values.end() );
+  return *middle;
+}
+
+
+const std::pair< int, int > PolyBuilder::partition( const std::vector< Bin >& bins,
+                                                    const double& xmin, const double& xmax,
+                                                    const double& ymin, const double& ymax )
+{
+  if ( bins.empty() )
+    return std::make_pair( 1, 1 );
+
+  std::vector< double > widths;
+  std::vector< double > heights;
+  widths .reserve( bins.size() );
+  heights.reserve( bins.size() );
+  for ( const Bin& bin : bins )
+  {
+    widths .push_back( bin.xhi() - bin.xlo() );
+    heights.push_back( bin.yhi() - bin.ylo() );
+  }
+
+  auto cells = []( const double& range, const double& size )
+  {
+    if ( ! ( size > 0.0 ) )
+      return 1;
+    return int( std::min( std::max( std::ceil( range / size ), 1.0 ), double( maxCells ) ) );
+  };
+
+  return std::make_pair( cells( xmax - xmin, median( widths  ) ),
+                         cells( ymax - ymin, median( heights ) ) );
+}
+
+
+void PolyBuilder::build( TH2Poly& hist, const std::vector< Bin >& bins )
+{
+  const std::pair< int, int >& grid = partition( bins,
+                                                 hist.GetXaxis()->GetXmin(), hist.GetXaxis()->GetXmax(),
+                                                 hist.GetYaxis()->GetXmin(), hist.GetYaxis()->GetXmax() );
+
+  // Set the partition before adding the bins, so that each bin is assigned to its cells only once.
+  hist.ChangePartition( grid.first, grid.second );
+
+  // Write the contours of all the bins at once.
+  const std::size_t& nBins = bins.size();
+  std::vector< double > x( 5 * nBins );
+  std::vector< double > y( 5 * nBins );
+  for ( std::size_t bin = 0; bin < nBins; ++bin )
+  {
+    double* xBin = &x[ 5 * bin ];
+    double* yBin = &y[ 5 * bin ];
+
+    xBin[ 0 ] = bins[ bin ].xlo(); yBin[ 0 ] = bins[ bin ].ylo();
+    xBin[ 1 ] = bins[ bin ].xlo(); yBin[ 1 ] = bins[ bin ].yhi();
+    xBin[ 2 ] = bins[ bin ].xhi(); yBin[ 2 ] = bins[ bin ].yhi();
+    xBin[ 3 ] = bins[ bin ].xhi(); yBin[ 3 ] = bins[ bin ].ylo();
+    xBin[ 4 ] = bins[ bin ].xlo(); yBin[ 4 ] = bins[ bin ].ylo();
+  }
+
+  for ( std::size_t bin = 0; bin < nBins; ++bin )
+  {
+    const int& idx = hist.AddBin( 5, &x[ 5 * bin ], &y[ 5 * bin ] );
+    hist.SetBinContent( idx, bins[ bin ].content() );
+  }
+}
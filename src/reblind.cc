@@ -1,7 +1,9 @@
 
 #include <iostream>
+#include <vector>
 
 #include <atools/blind.hh>
+#include <atools/tokens.hh>
 #include <rtools/rblind.hh>
 
 #include <root/RooUnblindOffset.h>
@@ -9,22 +11,50 @@
 
 
 // Convert a root blind value into a randomized blind value.
+//    reblind value   [blindStr [scale [type]]]    Convert a single value.
+//    reblind -       [blindStr [scale [type]]]    Convert all the values of the standard input.
+//    reblind -f file [blindStr [scale [type]]]    Convert all the values of a file.
+// In batch mode, each line of the output has the converted value of one input value.
 int main( int argc, char** argv )
 {
+  if ( argc < 2 )
+  {
+    std::cerr << "Usage: " << argv[ 0 ] << " value|-|-f file [blindStr [scale [type]]]" << std::endl;
+    return 1;
+  }
+
+  const std::string& mode  = argv[ 1 ];
+  const int          first = ( mode == "-f" ) ? 3 : 2;
+
   std::string blindStr = "default blinding string";
   double      scale    = 0.02;
   std::string blindTyp = "uniform";
-  if ( argc > 2 ) blindStr = argv[ 2 ];
-  if ( argc > 3 ) scale    = atof( argv[ 3 ] );
-  if ( argc > 4 ) blindTyp = argv[ 4 ];
+  if ( argc > first     ) blindStr = argv[ first     ];
+  if ( argc > first + 1 ) scale    = atof( argv[ first + 1 ] );
+  if ( argc > first + 2 ) blindTyp = argv[ first + 2 ];
+
+  std::vector< double > values;
+  if ( mode == "-" || mode == "-f" )
+  {
+    std::string error;
+    if ( ! Tokens::numbers( ( mode == "-f" && argc > 2 ) ? argv[ 2 ] : "-", values, error ) )
+    {
+      std::cerr << error << std::endl;
+      return 1;
+    }
+  }
+  else
+    values.push_back( atof( argv[ 1 ] ) );
 
   RBlind rblinder( blindStr, scale );
   Blind  blinder( 4 );
 
-  if ( blindTyp == "uniform" )
-    std::cout << blinder.blind( rblinder.unblind< RooUnblindUniform >( atof( argv[ 1 ] ) ) ) << std::endl;
-  else
-    std::cout << blinder.blind( rblinder.unblind< RooUnblindOffset  >( atof( argv[ 1 ] ) ) ) << std::endl;
+  for ( double& value : values )
+    value = ( blindTyp == "uniform" ) ? rblinder.unblind< RooUnblindUniform >( value )
+                                      : rblinder.unblind< RooUnblindOffset  >( value );
+
+  for ( const std::string& blind : blinder.blind( values ) )
+    std::cout << blind << "\n";
 
   return 0;
 }
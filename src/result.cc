@@ -25,10 +25,11 @@ Result::Result( const std::string& file )
   }
 
   typedef std::map< std::string, std::string >::const_iterator mIter;
-  const std::map< std::string, std::string > content = result.content();
+  const std::map< std::string, std::string >& content = result.content();
 
+  // The content is already sorted by name, so every parameter goes at the end of the map.
   for( mIter entry = content.begin(); entry != content.end(); ++entry )
-    _pars[ entry->first ] = Utils::makePar( entry->first, entry->second );
+    _pars.emplace_hint( _pars.end(), entry->first, Utils::makePar( entry->first, entry->second ) );
 }
 
 
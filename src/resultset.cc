@@ -0,0 +1,220 @@
+
+#include <cmath>
+#include <limits>
+#include <iostream>
+#include <algorithm>
+#include <string_view>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <atools/parse.hh>
+#include <atools/parspec.hh>
+#include <atools/resultset.hh>
+#include <atools/scheduler.hh>
+
+
+static std::string_view trim( std::string_view str )
+{
+  while ( ! str.empty() && Parse::isSpace( str.front() ) )
+    str.remove_prefix( 1 );
+  while ( ! str.empty() && Parse::isSpace( str.back() ) )
+    str.remove_suffix( 1 );
+
+  return str;
+}
+
+
+// Read the parameters of a result file, as written by Utils::getOutput.
+//    The format is the one Result reads through ConfigFile, with "=" as delimiter
+//    and "------" as comment, restricted to one parameter per line.
+bool ResultSet::parse( const std::string& file, std::vector< std::pair< std::string, ParSpec > >& pars, std::string& error )
+{
+  const int fd = open( file.c_str(), O_RDONLY );
+  if ( fd == -1 )
+  {
+    error = "File " + file + " does not exist.";
+    return false;
+  }
+
+  struct stat info;
+  if ( fstat( fd, &info ) == -1 )
+  {
+    close( fd );
+    error = "Cannot read file " + file + ".";
+    return false;
+  }
+
+  // Empty files cannot be mapped, but are valid results with no parameters.
+  const std::size_t size = info.st_size;
+  if ( ! size )
+  {
+    close( fd );
+    return true;
+  }
+
+  void* map = mmap( 0, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+  close( fd );
+  if ( map == MAP_FAILED )
+  {
+    error = "Cannot map file " + file + ".";
+    return false;
+  }
+  madvise( map, size, MADV_SEQUENTIAL );
+
+  std::string_view content( (const char*) map, size );
+
+  bool valid = true;
+  while ( ! content.empty() )
+  {
+    // Take the next line.
+    const std::size_t eol = content.find( '\n' );
+    std::string_view line = content.substr( 0, eol );
+    content.remove_prefix( eol == std::string_view::npos ? content.size() : eol + 1 );
+
+    // Ignore comments and stop at the end of file sentry.
+    line = line.substr( 0, line.find( "------" ) );
+    if ( line.find( "EndConfigFile" ) != std::string_view::npos )
+      break;
+
+    const std::size_t delim = line.find( '=' );
+    if ( delim == std::string_view::npos )
+      continue;
+
+    const std::string_view& key   = trim( line.substr( 0, delim ) );
+    const std::string_view& value = trim( line.substr( delim + 1 ) );
+
+    try
+    {
+      pars.emplace_back( std::string( key ), ParSpec::parse( value ) );
+    }
+    catch( ParSpecException& exc )
+    {
+      error = "File " + file + ", parameter " + std::string( key ) + ": " + exc.what();
+      valid = false;
+      break;
+    }
+  }
+
+  munmap( map, size );
+
+  return valid;
+}
+
+
+ResultSet::ResultSet( const std::vector< std::string >& files )
+{
+  const std::size_t& nFiles = files.size();
+
+  std::vector< std::vector< std::pair< std::string, ParSpec > > > pars( nFiles );
+  std::vector< std::string > errors( nFiles );
+  std::vector< char >        valid ( nFiles, false );
+
+  // Parse the files in parallel, one file per task.
+  Scheduler::parallel_for( 0, nFiles, [&]( const std::size_t& first, const std::size_t& last )
+                           {
+                             for ( std::size_t file = first; file < last; ++file )
+                               valid[ file ] = parse( files[ file ], pars[ file ], errors[ file ] );
+                           }, 1 );
+
+  // Count the valid results, to size the columns.
+  std::size_t nValid = 0;
+  for ( std::size_t file = 0; file < nFiles; ++file )
+    if ( valid[ file ] )
+      ++nValid;
+    else
+      std::cout << errors[ file ] << std::endl;
+
+  // Store the results in the order of the files, for reproducibility.
+  const double nan = std::numeric_limits< double >::quiet_NaN();
+  _files.reserve( nValid );
+  for ( std::size_t file = 0; file < nFiles; ++file )
+  {
+    if ( ! valid[ file ] )
+      continue;
+
+    const std::size_t& row = _files.size();
+    _files.push_back( files[ file ] );
+
+    for ( const std::pair< std::string, ParSpec >& par : pars[ file ] )
+    {
+      std::unordered_map< std::string, std::size_t >::const_iterator col = _index.find( par.first );
+      if ( col == _index.end() )
+      {
+        col = _index.emplace( par.first, _columns.size() ).first;
+        _names.push_back( par.first );
+        _columns.emplace_back();
+
+        Column& column = _columns.back();
+        column.values  .assign( nValid, nan );
+        column.errors  .assign( nValid, nan );
+        column.loLimits.assign( nValid, nan );
+        column.upLimits.assign( nValid, nan );
+      }
+
+      Column& column = _columns[ col->second ];
+      const ParSpec& spec = par.second;
+      column.values[ row ] = spec.value();
+      column.errors[ row ] = spec.error();
+      if ( spec.limited() )
+      {
+        column.loLimits[ row ] = spec.loLimit();
+        column.upLimits[ row ] = spec.upLimit();
+      }
+    }
+
+    // Release the memory of the parsed file as soon as it has been stored.
+    std::vector< std::pair< std::string, ParSpec > >().swap( pars[ file ] );
+  }
+}
+
+
+const std::vector< double > ResultSet::residuals( const std::string& name, const double& truth ) const
+{
+  const std::vector< double >& vals = values( name );
+
+  std::vector< double > result( vals.size() );
+  for ( std::size_t row = 0; row < vals.size(); ++row )
+    result[ row ] = vals[ row ] - truth;
+
+  return result;
+}
+
+
+const std::vector< double > ResultSet::pulls( const std::string& name, const double& truth ) const
+{
+  const Column& col = column( name );
+
+  // Results without a valid error have no pull.
+  std::vector< double > result( col.values.size() );
+  for ( std::size_t row = 0; row < col.values.size(); ++row )
+    result[ row ] = ( col.errors[ row ] > 0.0 ) ? ( col.values[ row ] - truth ) / col.errors[ row ]
+                                                : std::numeric_limits< double >::quiet_NaN();
+
+  return result;
+}
+
+
+const std::pair< double, double > ResultSet::meanAndSigma( const std::vector< double >& values )
+{
+  // Welford's update, which does not cancel for values with a large mean and a small spread.
+  double      mean = 0.0;
+  double      sqs  = 0.0; // Sum of the squared deviations from the mean.
+  std::size_t n    = 0;
+
+  for ( const double& value : values )
+    if ( ! std::isnan( value ) )
+    {
+      ++n;
+      const double& delta = value - mean;
+      mean += delta / n;
+      sqs  += delta * ( value - mean );
+    }
+
+  if ( ! n )
+    return std::make_pair( std::numeric_limits< double >::quiet_NaN(), std::numeric_limits< double >::quiet_NaN() );
+
+  return std::make_pair( mean, std::sqrt( sqs / n ) );
+}
@@ -1,7 +1,10 @@
 
 #include <iostream>
 #include <iomanip>
+#include <limits>
+#include <vector>
 
+#include <atools/tokens.hh>
 #include <rtools/rblind.hh>
 
 #include <root/RooUnblindOffset.h>
@@ -9,19 +12,51 @@
 
 
 // Unblind a roofit blind value.
+//    runblind value   [blindStr [scale]]    Print the offset and uniform unblinded values.
+//    runblind -       [blindStr [scale]]    Unblind all the values of the standard input.
+//    runblind -f file [blindStr [scale]]    Unblind all the values of a file.
+// In batch mode, each line of the output has the offset and uniform unblinded values of one input value.
 int main( int argc, char** argv )
 {
-  const double& value = atof( argv[ 1 ] );
+  if ( argc < 2 )
+  {
+    std::cerr << "Usage: " << argv[ 0 ] << " value|-|-f file [blindStr [scale]]" << std::endl;
+    return 1;
+  }
+
+  const std::string& mode  = argv[ 1 ];
+  const bool         batch = ( mode == "-" || mode == "-f" );
+  const int          first = ( mode == "-f" ) ? 3 : 2;
 
   std::string blindStr = "default blinding string";
   double      scale    = 0.02;
-  if ( argc > 2 ) blindStr = argv[ 2 ];
-  if ( argc > 3 ) scale    = atof( argv[ 3 ] );
+  if ( argc > first     ) blindStr = argv[ first     ];
+  if ( argc > first + 1 ) scale    = atof( argv[ first + 1 ] );
 
   RBlind blinder( blindStr, scale );
 
-  std::cout << "UnblindOffset:  " << std::setprecision( 40 ) << blinder.unblind< RooUnblindOffset  >( value ) << std::endl;
-  std::cout << "UnblindUniform: " << std::setprecision( 40 ) << blinder.unblind< RooUnblindUniform >( value ) << std::endl;
+  if ( ! batch )
+  {
+    const double& value = atof( argv[ 1 ] );
+
+    std::cout << "UnblindOffset:  " << std::setprecision( 40 ) << blinder.unblind< RooUnblindOffset  >( value ) << std::endl;
+    std::cout << "UnblindUniform: " << std::setprecision( 40 ) << blinder.unblind< RooUnblindUniform >( value ) << std::endl;
+
+    return 0;
+  }
+
+  std::vector< double > values;
+  std::string           error;
+  if ( ! Tokens::numbers( ( mode == "-f" && argc > 2 ) ? argv[ 2 ] : "-", values, error ) )
+  {
+    std::cerr << error << std::endl;
+    return 1;
+  }
+
+  std::cout << std::setprecision( std::numeric_limits< double >::max_digits10 );
+  for ( const double& value : values )
+    std::cout << blinder.unblind< RooUnblindOffset  >( value ) << " "
+              << blinder.unblind< RooUnblindUniform >( value ) << "\n";
 
   return 0;
 }
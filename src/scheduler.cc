@@ -0,0 +1,288 @@
+
+#include <deque>
+#include <memory>
+#include <thread>
+#include <cstdlib>
+#include <condition_variable>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <atools/ConfigFile.hh>
+#include <atools/scheduler.hh>
+
+
+// Pool of worker threads with a queue of tasks each. Queue 0 belongs to the threads
+//    that are not workers of the pool.
+class Pool
+{
+private:
+  struct Queue
+  {
+    std::mutex                            lock;
+    std::deque< std::function< void() > > tasks;
+  };
+
+  std::vector< std::unique_ptr< Queue > > _queues;
+  std::vector< std::thread >              _threads;
+
+  std::atomic< std::size_t > _queued;
+  std::mutex                 _sleepLock;
+  std::condition_variable    _wakeup;
+  bool                       _stop;
+
+  void work( const unsigned& index, const bool& pin );
+
+public:
+  Pool( const unsigned& nThreads, const bool& pin );
+  ~Pool();
+
+  void push( const std::function< void() >& task );
+  bool pop ( std::function< void() >& task );
+};
+
+
+// Pool and queue of the current thread, if it is a worker.
+static thread_local Pool*    workerPool  = 0;
+static thread_local unsigned workerIndex = 0;
+
+
+Pool::Pool( const unsigned& nThreads, const bool& pin )
+  : _queued( 0 ), _stop( false )
+{
+  for ( unsigned queue = 0; queue < std::max( nThreads, 1u ); ++queue )
+    _queues.emplace_back( new Queue );
+
+  for ( unsigned index = 1; index < nThreads; ++index )
+    _threads.emplace_back( &Pool::work, this, index, pin );
+}
+
+
+Pool::~Pool()
+{
+  {
+    std::lock_guard< std::mutex > lock( _sleepLock );
+    _stop = true;
+  }
+  _wakeup.notify_all();
+
+  for ( std::thread& thread : _threads )
+    thread.join();
+}
+
+
+void Pool::work( const unsigned& index, const bool& pin )
+{
+  workerPool  = this;
+  workerIndex = index;
+
+#ifdef __linux__
+  if ( pin )
+  {
+    cpu_set_t cpus;
+    CPU_ZERO( &cpus );
+    CPU_SET( index % std::max( 1u, std::thread::hardware_concurrency() ), &cpus );
+    pthread_setaffinity_np( pthread_self(), sizeof( cpus ), &cpus );
+  }
+#endif
+
+  std::function< void() > task;
+  while ( true )
+  {
+    if ( pop( task ) )
+    {
+      task();
+      continue;
+    }
+
+    std::unique_lock< std::mutex > lock( _sleepLock );
+    _wakeup.wait( lock, [ this ]() { return _stop || _queued > 0; } );
+    if ( _stop && ! _queued )
+      return;
+  }
+}
+
+
+void Pool::push( const std::function< void() >& task )
+{
+  Queue& queue = *_queues[ ( workerPool == this ) ? workerIndex : 0 ];
+  {
+    std::lock_guard< std::mutex > lock( queue.lock );
+    queue.tasks.push_back( task );
+  }
+  _queued++;
+
+  // Taking the lock ensures that a worker about to sleep sees the new task.
+  {
+    std::lock_guard< std::mutex > lock( _sleepLock );
+  }
+  _wakeup.notify_one();
+}
+
+
+// Take the newest task of the own queue or, failing that, the oldest task of another.
+bool Pool::pop( std::function< void() >& task )
+{
+  if ( ! _queued )
+    return false;
+
+  const std::size_t& nQueues = _queues.size();
+  const unsigned&    own     = ( workerPool == this ) ? workerIndex : 0;
+  for ( std::size_t offset = 0; offset < nQueues; ++offset )
+  {
+    Queue& queue = *_queues[ ( own + offset ) % nQueues ];
+
+    std::lock_guard< std::mutex > lock( queue.lock );
+    if ( queue.tasks.empty() )
+      continue;
+
+    if ( offset == 0 )
+    {
+      task = std::move( queue.tasks.back() );
+      queue.tasks.pop_back();
+    }
+    else
+    {
+      task = std::move( queue.tasks.front() );
+      queue.tasks.pop_front();
+    }
+
+    _queued--;
+    return true;
+  }
+
+  return false;
+}
+
+
+// The pool is created on first use. The pointer lets the waiting threads find it
+//    without taking the lock.
+static std::mutex              poolLock;
+static std::unique_ptr< Pool > pool;
+static std::atomic< Pool* >    current( 0 );
+static unsigned                configuredThreads = 0;
+static bool                    pinThreads        = false;
+
+
+// A forked process only has the thread that called fork, so the child abandons the pool
+//    it inherits, whose workers do not exist in it, and creates its own on first use.
+//    Holding the lock across the fork keeps the pool from being replaced meanwhile.
+static void prepareFork() { poolLock.lock();   }
+static void parentFork () { poolLock.unlock(); }
+static void childFork  ()
+{
+  // The old pool is leaked, since joining its threads is not possible.
+  pool.release();
+  current = 0;
+  poolLock.unlock();
+}
+
+static const int forkHandlers = pthread_atfork( prepareFork, parentFork, childFork );
+
+
+static Pool& instance()
+{
+  if ( Pool* existing = current.load( std::memory_order_acquire ) )
+    return *existing;
+
+  std::lock_guard< std::mutex > lock( poolLock );
+  if ( ! pool )
+  {
+    pool.reset( new Pool( Scheduler::nThreads(), pinThreads ) );
+    current.store( pool.get(), std::memory_order_release );
+  }
+
+  return *pool;
+}
+
+
+void Scheduler::configure( const unsigned& nThreads, const bool& pin )
+{
+  std::lock_guard< std::mutex > lock( poolLock );
+  current = 0;
+  pool.reset();
+  configuredThreads = nThreads;
+  pinThreads        = pin;
+}
+
+
+void Scheduler::configure( const ConfigFile& config )
+{
+  configure( config.keyExists( "threads"    ) ? config.read< unsigned >( "threads"    ) : configuredThreads,
+             config.keyExists( "pinThreads" ) ? config.read< bool     >( "pinThreads" ) : pinThreads );
+}
+
+
+const unsigned Scheduler::nThreads()
+{
+  if ( configuredThreads )
+    return configuredThreads;
+
+  const char* env = std::getenv( "ATOOLS_THREADS" );
+  if ( env && std::atoi( env ) > 0 )
+    return std::atoi( env );
+
+  return std::max( 1u, std::thread::hardware_concurrency() );
+}
+
+
+std::size_t Scheduler::chunk( const std::size_t& size, const std::size_t& grain )
+{
+  if ( grain )
+    return grain;
+
+  return std::max< std::size_t >( 1, ( size + 255 ) / 256 );
+}
+
+
+void Scheduler::submit( const std::function< void() >& task )
+{
+  instance().push( task );
+}
+
+
+bool Scheduler::runOne()
+{
+  std::function< void() > task;
+  if ( ! instance().pop( task ) )
+    return false;
+
+  task();
+  return true;
+}
+
+
+void Scheduler::TaskGroup::run( const std::function< void() >& task )
+{
+  _pending++;
+  submit( [ this, task ]()
+          {
+            try
+            {
+              task();
+            }
+            catch ( ... )
+            {
+              std::lock_guard< std::mutex > lock( _lock );
+              if ( ! _error )
+                _error = std::current_exception();
+            }
+            _pending--;
+          } );
+}
+
+
+void Scheduler::TaskGroup::wait( const bool& rethrow )
+{
+  // Help with the queued tasks, which may belong to this group or to others.
+  while ( _pending )
+    if ( ! runOne() )
+      std::this_thread::yield();
+
+  if ( rethrow && _error )
+  {
+    std::exception_ptr error = _error;
+    _error = nullptr;
+    std::rethrow_exception( error );
+  }
+}
@@ -9,6 +9,8 @@
 #include <root/TBranch.h>
 #include <root/TIterator.h>
 
+#include <atools/instrument.hh>
+
 #include <rtools/tupledata.hh>
 
 // This appears to just be a front end to interfacing with root - this effectively holds a root file, or a series of root files, and allows you to probe some very specific elements of them.
@@ -21,6 +23,8 @@
     if ( files == "" )
         return;
 
+    INSTRUMENT_SCOPE( "TupleData::open" );
+
     _chain = new TChain( branch.data() ); // branch is "gamma/kshh" which is the TDirectory/TTree address of the data TTree in the file. I assume this tells the TTree constructor to look for the data in this location, but idk why branch by itself wouldn't work
     _current = -1; // Just initialising this to a dummy value
 
@@ -79,31 +83,16 @@ void TupleData::setAddresses()
         if ( title.find( "[" ) != std::string::npos )
             throw BranchException( "Refusing to handle the array branch " + name + "." );
 
-        // Allocate space for an array of the required length for array branches.
-        // As each title should have the type as the final character, this figures out the type for each branch and makes an appropriate variable
-        // _values is a std::map<std::string, *void>, whatever that means... Maybe a key-value pair?
-        if ( *( title.rbegin() ) == std::string( "O" ) )
-            _values[ name.c_str() ] = new bool;
-        if ( *( title.rbegin() ) == std::string( "B" ) )
-            _values[ name.c_str() ] = new char;
-        if ( *( title.rbegin() ) == std::string( "b" ) )
-            _values[ name.c_str() ] = new unsigned char;
-        if ( *( title.rbegin() ) == std::string( "S" ) )
-            _values[ name.c_str() ] = new short;
-        if ( *( title.rbegin() ) == std::string( "s" ) )
-            _values[ name.c_str() ] = new unsigned short;
-        if ( *( title.rbegin() ) == std::string( "I" ) )
-            _values[ name.c_str() ] = new int;
-        if ( *( title.rbegin() ) == std::string( "i" ) )
-            _values[ name.c_str() ] = new unsigned int;
-        if ( *( title.rbegin() ) == std::string( "L" ) )
-            _values[ name.c_str() ] = new long;
-        if ( *( title.rbegin() ) == std::string( "l" ) )
-            _values[ name.c_str() ] = new unsigned long;
-        if ( *( title.rbegin() ) == std::string( "F" ) )
-            _values[ name.c_str() ] = new float;
-        if ( *( title.rbegin() ) == std::string( "D" ) )
-            _values[ name.c_str() ] = new double;
+        // Allocate space for the value of the branch. As each title should have the type as the final character,
+        //    only branches of known types get a buffer. All the types fit in 8 bytes, and the buffers are
+        //    kept in a deque, so that their addresses do not change as more are added, and freed with the object.
+        if ( std::string( "ObBsSiIlLFD" ).find( *( title.rbegin() ) ) != std::string::npos )
+        {
+            _buffers.push_back( 0 );
+            _values[ name.c_str() ] = &_buffers.back();
+        }
+        else
+            _values[ name.c_str() ] = 0;
 
         // Link the pointer to the variable name to its corresponding branch in the chain.
         _chain->SetBranchAddress( name.c_str(), _values[ name.c_str() ] );
@@ -114,6 +103,8 @@ void TupleData::setAddresses()
 // Fill the object with specified entry.
 int TupleData::getEntry( const long& entry )
 {
+    INSTRUMENT_TIME( "TupleData::getEntry" );
+
     // Set the environment to read one entry
     if ( ! _chain )
         return 0;
@@ -125,8 +116,11 @@ int TupleData::getEntry( const long& entry )
     if ( _chain->GetTreeNumber() != _current )
         _current = _chain->GetTreeNumber();
 
-    // Read contents of specified entry and return the entry number.
-    return _chain->GetEntry( entry );
+    // Read contents of specified entry and return the number of bytes read.
+    const int bytes = _chain->GetEntry( entry );
+    INSTRUMENT_COUNT( bytesRead, std::max( bytes, 0 ) );
+
+    return bytes;
 }
 
 
@@ -1,17 +1,142 @@
 
 #include <iostream>
 #include <iomanip>
+#include <sstream>
+#include <fstream>
+#include <limits>
+#include <vector>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include <atools/blind.hh>
+#include <atools/scheduler.hh>
+#include <atools/tokens.hh>
+
+
+// Replace every blinded value of a text by its unblinded value.
+static std::string unblindText( const std::string& text )
+{
+  Blind blinder( 4 );
+
+  std::ostringstream value;
+  value << std::setprecision( std::numeric_limits< double >::max_digits10 );
+
+  return Tokens::rewrite( text, [&]( const std::string_view& token, std::string& output )
+                          {
+                            if ( ! blinder.isBlinded< double >( token ) )
+                              return false;
+
+                            value.str( "" );
+                            value << blinder.unblind< double >( std::string( token ) );
+                            output += value.str();
+                            return true;
+                          } );
+}
+
+
+// Replace the contents of a file, writing them to a temporary file in the same directory
+//    that is renamed over the original, so the file is never left half written.
+static bool replaceFile( const std::string& file, const std::string& text )
+{
+  struct stat info;
+  if ( stat( file.c_str(), &info ) == -1 )
+    return false;
+
+  std::string temporary = file + ".XXXXXX";
+  const int fd = mkstemp( &temporary[ 0 ] );
+  if ( fd == -1 )
+    return false;
+
+  bool ok = ( fchmod( fd, info.st_mode & 07777 ) == 0 );
+  for ( std::size_t done = 0; ok && done < text.size(); )
+  {
+    const ssize_t& written = write( fd, text.data() + done, text.size() - done );
+    ok = ( written > 0 );
+    done += ok ? written : 0;
+  }
+  ok = ( fsync( fd ) == 0 ) && ok;
+  ok = ( close( fd ) == 0 ) && ok;
+
+  if ( ok && std::rename( temporary.c_str(), file.c_str() ) == 0 )
+    return true;
+
+  std::remove( temporary.c_str() );
+  return false;
+}
 
 
 // Unblind a randomized blind value.
+//    unblind value [value...]     Print each unblinded value.
+//    unblind -                    Rewrite the standard input to the standard output.
+//    unblind -f file [file...]    Rewrite the files to the standard output, in order.
+//    unblind -i file [file...]    Rewrite the files in place.
+// Files are processed in parallel, with ATOOLS_THREADS threads if it is set.
 int main( int argc, char** argv )
 {
   Blind blinder( 4 );
 
-  for ( int arg = 1; arg < argc; ++arg )
-    std::cout << std::setprecision( 40 ) << blinder.unblind<double>( argv[ arg ] ) << std::endl;
+  const std::string& mode = ( argc > 1 ) ? argv[ 1 ] : "";
+
+  if ( mode == "-" )
+  {
+    std::string text;
+    Tokens::read( "-", text );
+    std::cout << unblindText( text );
+    return 0;
+  }
+
+  if ( mode != "-f" && mode != "-i" )
+  {
+    for ( int arg = 1; arg < argc; ++arg )
+      std::cout << std::setprecision( 40 ) << blinder.unblind<double>( argv[ arg ] ) << std::endl;
+
+    return 0;
+  }
+
+  const bool inPlace = ( mode == "-i" );
+
+  const std::vector< std::string > files( argv + 2, argv + argc );
+  const std::size_t& nFiles = files.size();
+
+  std::vector< std::string > outputs( nFiles );
+  std::vector< char >        failed ( nFiles, false );
+
+  // Process one file per task.
+  Scheduler::parallel_for( 0, nFiles, [&]( const std::size_t& first, const std::size_t& last )
+  {
+    std::string text;
+    for ( std::size_t file = first; file < last; ++file )
+    {
+      if ( ! Tokens::read( files[ file ], text ) )
+      {
+        failed[ file ] = true;
+        continue;
+      }
+
+      outputs[ file ] = unblindText( text );
+
+      if ( inPlace )
+      {
+        failed[ file ] = ! replaceFile( files[ file ], outputs[ file ] );
+        std::string().swap( outputs[ file ] );
+      }
+    }
+  }, 1 );
+
+  int status = 0;
+  for ( std::size_t file = 0; file < nFiles; ++file )
+  {
+    if ( failed[ file ] )
+    {
+      std::cerr << "Cannot process file " << files[ file ] << "." << std::endl;
+      status = 1;
+    }
+    else if ( ! inPlace )
+      std::cout << outputs[ file ];
+  }
 
-  return 0;
+  return status;
 }
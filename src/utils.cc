@@ -18,6 +18,7 @@
 #include <atools/blind.hh>
 #include <atools/utils.hh>
 #include <atools/math.hh>
+#include <atools/parspec.hh>
 
 
 
@@ -302,69 +303,35 @@ const std::string Utils::getOutput( const MnUserParameters& pars, const MnUserCo
 }
 
 
-const Parameter Utils::makePar( const std::string& name, std::string info )
+const Parameter Utils::makePar( const std::string& name, const std::string& info )
 {
-    info = Utils::replace( info, "(", " (" ); // Make the L a different token.
-    info = Utils::replace( info, ",", " "  ); // Remove commas from ranges.
-    info = Utils::replace( info, "*", " "  ); // Remove * from ranges, indicating
-    //    result at the limit.
-    double value   =  0.0;
-    double error   = -1.0;
-    double loLimit =  0.0;
-    double upLimit =  0.0;
-    bool   isFixed = false;
-    bool   isBlind = false;
-    bool   limited = false;
-    bool   unset   = true;  // To check if value has been set.
-
-    // Tokenize the resonance information.
-    std::istringstream tokens( info );
-    std::string token;
-    while( tokens >> token )
+    ParSpec spec;
+
+    try
     {
-        if ( token == "C" )
-            isFixed = true;
-        else if ( token == "B" )
-            isBlind = true;
-        else if ( token == "L" )
-        {
-            tokens >> token >> loLimit >> upLimit; // token will be '('.
-            limited = true;
-        }
-        else if ( token == "+-" )
-            tokens >> error;
-        else if ( token == "-" )
-        {
-            tokens >> value;
-            value *= -1.0;
-            unset = false;
-        }
-        else if ( unset )
-        {
-            value = Utils::fromStr< double >( token );
-            unset = false;
-        }
-        else if ( token != ")" )
-        {
-            std::cerr << "\e[91mDon't know what to do with token " << token << "\e[0m" << std::endl;
-            std::cerr << "\e[91mExpression \"\e[1m" << info << "\e[21m\" is not a parameter initialization.\e[0m" << std::endl;;
-            throw std::exception();
-        }
+        spec = ParSpec::parse( info );
+    }
+    catch( ParSpecException& error )
+    {
+        std::cerr << "\e[91m" << error.what() << "\e[0m" << std::endl;
+        std::cerr << "\e[91mExpression \"\e[1m" << info << "\e[21m\" is not a parameter initialization.\e[0m" << std::endl;
+        std::cerr << "\e[91m            " << std::string( error.position(), ' ' ) << "^\e[0m" << std::endl;
+        throw;
     }
 
-    if ( unset )
+    if ( ! spec.isSet() )
         std::cout << "Something is wrong with parameter " << name << ", which is unset." << std::endl;
 
     // Create the parameter to be returned.
-    Parameter par( name, value, error );
+    Parameter par( name, spec.value(), spec.error() );
 
     // Fix, blind and limit if requested.
-    if ( isFixed )
+    if ( spec.isFixed() )
         par.fix();
-    if ( isBlind )
+    if ( spec.isBlind() )
         par.blind();
-    if ( limited )
-        par.setLimits( loLimit, upLimit );
+    if ( spec.limited() )
+        par.setLimits( spec.loLimit(), spec.upLimit() );
 
     return par;
 }
@@ -392,17 +359,23 @@ const Parameter Utils::makePar( const ConfigFile& config, const std::string& nam
 //    parameter name to be read from it. This is the one used in fitter.cc
 const Parameter Utils::makePar( const ConfigFile& config, const std::string& section, const std::string& name )
 {
-    // No need to catch exceptions. If any of these section readings throws ConfigFile::section_not_found,
-    //    this function would throw anyway at the return line.
-    const std::string& prefix = config.readSection< std::string >( section, "prefix", "" );
-    const std::string& suffix = config.readSection< std::string >( section, "suffix", "" );
+    // No need to catch exceptions. If the section does not exist, ConfigFile::section_not_found
+    //    is thrown, as it would be when reading the parameter itself.
+    // Resolve the three keys in a single pass over the section and its "same" references.
+    const std::vector< const std::string* >& values = config.resolve( section, { "prefix", "suffix", name } );
+
+    if ( ! values[ 2 ] )
+        throw ConfigFile::key_not_found( name );
+
+    const std::string& prefix = values[ 0 ] ? *values[ 0 ] : "";
+    const std::string& suffix = values[ 1 ] ? *values[ 1 ] : "";
 
     std::string parname;
     parname += prefix + ( prefix.empty() ? "" : "_" );
     parname += name;
     parname += ( suffix.empty() ? "" : "_" ) + suffix;
 
-    return makePar( parname, config.readSection< std::string >( section, name ) );
+    return makePar( parname, *values[ 2 ] );
 }
 
 